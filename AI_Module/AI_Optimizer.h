@@ -3,27 +3,13 @@
 
 #include <string>
 #include <vector>
-
-enum AlgorithmType {
-    BUBBLE_SORT,
-    INSERTION_SORT,
-    MERGE_SORT,
-    QUICK_SORT
-};
-
-struct DatasetFeatures {
-    int size;
-    double sortednessRatio;
-    double reversedRatio;
-    double uniqueRatio;
-    bool isLargeDataset;
-};
+#include "Sort_Types.h"
 
 class AIOptimizer {
 public:
     static DatasetFeatures analyzeDataset(int* arr, int n);
     static AlgorithmType predict(DatasetFeatures features);
-    static std::string getAlgorithmName(AlgorithmType type);
+    static const std::string& getAlgorithmName(AlgorithmType type);
     static void printAnalysisReport(DatasetFeatures features, AlgorithmType recommendation);
     
 private:
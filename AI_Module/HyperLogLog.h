@@ -0,0 +1,82 @@
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// HyperLogLog 基数估计 (不同值个数)，AIOptimizer、KNNOptimizer 与 CLI/GUI 引擎共用
+// 2^12 个单字节寄存器 (4 KB，成员数组，不做堆分配)
+// 标准误差 1.04 / sqrt(4096) ≈ 1.6%；基数较小时改用线性计数，接近精确
+class HyperLogLog {
+public:
+    static const int PRECISION = 12;
+    static const int REGISTERS = 1 << PRECISION;
+
+    HyperLogLog() { clear(); }
+
+    void clear() { registers.fill(0); }
+
+    void add(int value) {
+        uint64_t h = mix((uint32_t)value);
+        int index = (int)(h >> (64 - PRECISION));
+        // 哨兵位保证剩余位全为 0 时秩也有上限
+        uint64_t w = (h << PRECISION) | (1ULL << (PRECISION - 1));
+        uint8_t rank = 1;
+        while (!(w & (1ULL << 63))) {
+            w <<= 1;
+            rank++;
+        }
+        registers[index] = std::max(registers[index], rank);
+    }
+
+    double estimate() const {
+        // 寄存器可能取到的每个秩对应的 2^-rank (逐个寄存器调用 ldexp 在小输入上是主要开销)
+        // 常量初始化，调用时没有局部静态变量的初始化检查
+#define HLL_POW4(r) 1.0 / (1ULL << (r)), 1.0 / (1ULL << ((r) + 1)), 1.0 / (1ULL << ((r) + 2)), 1.0 / (1ULL << ((r) + 3))
+#define HLL_POW16(r) HLL_POW4(r), HLL_POW4((r) + 4), HLL_POW4((r) + 8), HLL_POW4((r) + 12)
+        static const double inversePowers[64] = {HLL_POW16(0), HLL_POW16(16), HLL_POW16(32), HLL_POW16(48)};
+#undef HLL_POW16
+#undef HLL_POW4
+        double sum = 0.0;
+        int zeros = 0;
+        for (uint8_t r : registers) {
+            sum += inversePowers[r];
+            if (r == 0) zeros++;
+        }
+        double m = REGISTERS;
+        double raw = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0) return m * std::log(m / zeros);
+        return raw;
+    }
+
+    // n 个值中不同值的个数，value(i) 给出第 i 个值 (按 i 递增调用)
+    // 少于 REGISTERS 个值时复制到栈上排序后精确计数：比清零再扫描 4 KB 寄存器便宜，
+    // n = 100 时后者是特征提取的主要开销；否则用草图估计
+    template <typename Value>
+    static double countDistinct(int n, Value value) {
+        if (n < REGISTERS) {
+            int values[REGISTERS];
+            for (int i = 0; i < n; i++) values[i] = value(i);
+            std::sort(values, values + n);
+            return (double)(std::unique(values, values + n) - values);
+        }
+        HyperLogLog sketch;
+        for (int i = 0; i < n; i++) sketch.add(value(i));
+        return sketch.estimate();
+    }
+
+private:
+    std::array<uint8_t, REGISTERS> registers;
+
+    // splitmix64 终结函数：把相邻整数打散到 64 位
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+};
+
+#endif // HYPERLOGLOG_H
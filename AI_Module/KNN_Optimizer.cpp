@@ -1,54 +1,34 @@
 #include "KNN_Optimizer.h"
+#include "AI_Optimizer.h"
 #include <iostream>
 #include <algorithm>
-#include <unordered_set>
-#include <map>
+#include <array>
 #include <limits>
 
 // 构造函数：初始化“专家知识库”
+// 标注点来自 KNN_TrainingSet.h (与 CLI/GUI 的 KnnSelector 共用)，这里取经典算法标签
 // 覆盖文档要求的所有场景：Random, Nearly Sorted, Reversed, Few Unique, Large Random
 KNNOptimizer::KNNOptimizer() {
-    // 格式: {Size, Sorted, Reversed, Unique}, BestAlgo
-    
-    // 1. 小数据集 (Small) -> Insertion Sort 最佳
-    trainingData.push_back({{30, 0.1, 0.1, 1.0}, INSERTION_SORT});
-    trainingData.push_back({{50, 0.9, 0.0, 1.0}, INSERTION_SORT}); // 有序
-    trainingData.push_back({{40, 0.0, 0.9, 1.0}, INSERTION_SORT}); // 逆序(小数据逆序插入排序也能接受)
-
-    // 2. 几乎有序 (Nearly Sorted) -> Insertion Sort (O(N))
-    trainingData.push_back({{500, 0.95, 0.0, 1.0}, INSERTION_SORT});
-    trainingData.push_back({{900, 0.92, 0.0, 1.0}, INSERTION_SORT});
-    // 注意：即使数据很大，如果是几乎完全有序，Insertion 依然很快，
-    // 但为了安全，通常我们在超大数据时会切换到 Quick/Merge，除非 Sortedness 极高。
-
-    // 3. 逆序 (Reversed) -> Quick Sort (必须避开 Insertion)
-    trainingData.push_back({{500, 0.0, 0.95, 1.0}, QUICK_SORT});
-    trainingData.push_back({{2000, 0.0, 0.99, 1.0}, QUICK_SORT}); 
-    trainingData.push_back({{5000, 0.0, 1.00, 1.0}, QUICK_SORT});
-
-    // 4. 重复元素多 (Few Unique) -> Merge Sort (稳定性 & 避免 QuickSort 最坏情况)
-    trainingData.push_back({{1000, 0.3, 0.3, 0.05}, MERGE_SORT}); // 极多重复
-    trainingData.push_back({{5000, 0.5, 0.2, 0.10}, MERGE_SORT});
-    trainingData.push_back({{800, 0.2, 0.2, 0.20}, MERGE_SORT});
-
-    // 5. 大规模随机数据 (Large Random) -> Quick Sort
-    trainingData.push_back({{2000, 0.5, 0.5, 1.0}, QUICK_SORT});
-    trainingData.push_back({{5000, 0.4, 0.4, 0.9}, QUICK_SORT});
-    trainingData.push_back({{10000, 0.5, 0.5, 1.0}, QUICK_SORT});
+    // 格式: {Size, Sorted, Reversed, Unique, IsLarge, RatioCells}, BestAlgo (后两项不参与距离计算)
+#define KNN_SAMPLE(size, sorted, reversed, unique, classic, engine) \
+    trainingData.push_back({{size, sorted, reversed, unique, (size) > 1000, \
+                             quantiseRatios(sorted, reversed, unique)}, classic});
+#include "KNN_TrainingSet.h"
+#undef KNN_SAMPLE
 }
 
 double KNNOptimizer::normalizeSize(int size) {
-    // 将 0-10000 映射到 0-1，超过 10000 按 1 处理
-    // 这是为了防止 Size 的数值过大主导了距离计算
-    double val = (double)size / 10000.0;
+    // 按数量级映射：log10(Size) / 7，即 1 到 10^7 映射到 0-1 (与 CLI/GUI 的 KnnSelector 相同)
+    // 这是为了防止 Size 的数值过大主导了距离计算，同时区分 10^4 以上的规模
+    double val = std::log10((double)std::max(size, 1)) / 7.0;
     return (val > 1.0) ? 1.0 : val;
 }
 
 double KNNOptimizer::calculateDistance(const DatasetFeatures& f1, const DatasetFeatures& f2) {
     double dSize = normalizeSize(f1.size) - normalizeSize(f2.size);
-    double dSort = f1.sortedness - f2.sortedness;
-    double dRev  = f1.reversedness - f2.reversedness;
-    double dUniq = f1.uniqueness - f2.uniqueness;
+    double dSort = f1.sortednessRatio - f2.sortednessRatio;
+    double dRev  = f1.reversedRatio - f2.reversedRatio;
+    double dUniq = f1.uniqueRatio - f2.uniqueRatio;
 
     // 加权欧几里得距离 (Weighted Euclidean Distance)
     // 我们认为 "有序度" 和 "逆序度" 对算法性能影响最大，给予 2 倍权重
@@ -61,27 +41,29 @@ double KNNOptimizer::calculateDistance(const DatasetFeatures& f1, const DatasetF
     );
 }
 
-AlgorithmType KNNOptimizer::predict(DatasetFeatures input, int k) {
+AlgorithmType KNNOptimizer::predict(DatasetFeatures input, int k, bool verbose) const {
     // 1. 计算所有距离
-    std::vector<std::pair<double, AlgorithmType>> neighbors;
+    // 缓冲区按线程复用 (clear 保留容量)，稳定状态下预测不做堆分配
+    thread_local std::vector<std::pair<double, AlgorithmType>> neighbors;
+    neighbors.clear();
     for (const auto& sample : trainingData) {
         double dist = calculateDistance(sample.features, input);
         neighbors.push_back({dist, sample.bestAlgo});
     }
 
-    // 2. 排序找到最近的 k 个
-    std::sort(neighbors.begin(), neighbors.end());
+    // 限制 k 不超过样本数
+    int limit = std::max(0, std::min(k, (int)neighbors.size()));
+
+    // 2. 只需把最近的 k 个排到前面
+    std::partial_sort(neighbors.begin(), neighbors.begin() + limit, neighbors.end());
 
     // 3. 加权投票 (Weighted Voting)
     // 权重公式: weight = 1 / (distance^2 + epsilon)
-    // 距离越近，权重越高
-    std::map<AlgorithmType, double> votes;
+    // 距离越近，权重越高；票箱是按算法编号索引的定长数组
+    std::array<double, QUICK_SORT + 1> votes{};
     double epsilon = 1e-5; // 防止除以 0
 
-    std::cout << "\n[KNN Analysis] Nearest Neighbors (k=" << k << "):" << std::endl;
-    
-    // 限制 k 不超过样本数
-    int limit = std::min(k, (int)neighbors.size());
+    if (verbose) std::cout << "\n[KNN Analysis] Nearest Neighbors (k=" << k << "):" << std::endl;
     
     for (int i = 0; i < limit; i++) {
         double dist = neighbors[i].first;
@@ -91,34 +73,37 @@ AlgorithmType KNNOptimizer::predict(DatasetFeatures input, int k) {
         double weight = 1.0 / (dist * dist + epsilon);
         votes[type] += weight;
 
-        std::cout << "  Rank " << i+1 << ": " << getAlgorithmName(type) 
-                  << " (Dist: " << dist << ", Weight: " << weight << ")" << std::endl;
+        if (verbose) std::cout << "  Rank " << i+1 << ": " << getAlgorithmName(type) 
+                               << " (Dist: " << dist << ", Weight: " << weight << ")" << std::endl;
     }
 
     // 4. 找出总权重最高的算法
+    // 没有得票的算法权重为 0，不会被选中；一张票都没有时默认 Quick Sort
     AlgorithmType bestAlgo = QUICK_SORT;
-    double maxWeight = -1.0;
+    double maxWeight = 0.0;
 
-    for (auto const& [algo, weight] : votes) {
-        if (weight > maxWeight) {
-            maxWeight = weight;
-            bestAlgo = algo;
+    for (int algo = BUBBLE_SORT; algo <= QUICK_SORT; algo++) {
+        if (votes[algo] > maxWeight) {
+            maxWeight = votes[algo];
+            bestAlgo = (AlgorithmType)algo;
         }
     }
     
-    std::cout << ">>> AI Raw Prediction: " << getAlgorithmName(bestAlgo) << std::endl;
+    if (verbose) std::cout << ">>> AI Raw Prediction: " << getAlgorithmName(bestAlgo) << std::endl;
 
     // 5. 混合模型：应用安全规则 (Hybrid Safety Mechanism)
     // 这是拿满分的关键：展示你不仅懂 AI，还懂系统稳定性
-    return enforceSafetyRules(bestAlgo, input.size);
+    return enforceSafetyRules(bestAlgo, input.size, verbose);
 }
 
-AlgorithmType KNNOptimizer::enforceSafetyRules(AlgorithmType predicted, int dataSize) {
+AlgorithmType KNNOptimizer::enforceSafetyRules(AlgorithmType predicted, int dataSize, bool verbose) {
     // 规则依据：文档 Page 8 "Arrays larger than 1000 elements should skip Bubble/Insertion"
     if (dataSize > 1000) {
         if (predicted == BUBBLE_SORT || predicted == INSERTION_SORT) {
-            std::cout << "[SAFETY OVERRIDE] Large dataset detected (>1000)." << std::endl;
-            std::cout << "  -> Overriding AI prediction (" << getAlgorithmName(predicted) << ") to prevent timeout." << std::endl;
+            if (verbose) {
+                std::cout << "[SAFETY OVERRIDE] Large dataset detected (>1000)." << std::endl;
+                std::cout << "  -> Overriding AI prediction (" << getAlgorithmName(predicted) << ") to prevent timeout." << std::endl;
+            }
             // 默认回退到 Quick Sort，除非之前的分析暗示了大量重复(这里简化为 Quick)
             return QUICK_SORT;
         }
@@ -127,39 +112,12 @@ AlgorithmType KNNOptimizer::enforceSafetyRules(AlgorithmType predicted, int data
 }
 
 DatasetFeatures KNNOptimizer::extractFeatures(int* arr, int n) {
-    DatasetFeatures f;
-    f.size = n;
-    
-    if (n <= 1) {
-        f.sortedness = 1.0; f.reversedness = 0.0; f.uniqueness = 1.0;
-        return f;
-    }
-
-    // 1. 扫描有序度与逆序度 (O(N))
-    long long asc = 0, desc = 0;
-    for (int i=0; i<n-1; i++) {
-        if (arr[i] <= arr[i+1]) asc++;
-        if (arr[i] >= arr[i+1]) desc++;
-    }
-    f.sortedness = (double)asc / (n-1);
-    f.reversedness = (double)desc / (n-1);
-
-    // 2. 采样估算唯一性 (Sampling for O(1) performance)
-    // 只取前 100 个做样本，避免大数组 O(N) 的 set 操作
-    int sampleSize = (n < 100) ? n : 100;
-    std::unordered_set<int> u;
-    for(int i=0; i<sampleSize; i++) u.insert(arr[i]);
-    f.uniqueness = (double)u.size() / sampleSize;
-
-    return f;
+    // 与规则模型使用同一份特征，两者的预测才可以直接比较
+    return AIOptimizer::analyzeDataset(arr, n);
 }
 
-std::string KNNOptimizer::getAlgorithmName(AlgorithmType type) {
-    switch (type) {
-        case BUBBLE_SORT: return "Bubble Sort";
-        case INSERTION_SORT: return "Insertion Sort";
-        case MERGE_SORT: return "Merge Sort";
-        case QUICK_SORT: return "Quick Sort";
-        default: return "Unknown";
-    }
+const std::string& KNNOptimizer::getAlgorithmName(AlgorithmType type) {
+    // 名字只构造一次，返回引用，每次调用不再复制字符串
+    static const std::string names[] = {"Bubble Sort", "Insertion Sort", "Merge Sort", "Quick Sort", "Unknown"};
+    return names[(type >= BUBBLE_SORT && type <= QUICK_SORT) ? type : QUICK_SORT + 1];
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+// k-NN 训练集：AI_Module (KNNOptimizer) 与 CLI/GUI (KnnSelector) 共用的唯一一份标注点
+//
+// 每行 KNN_SAMPLE(规模, 有序度, 逆序度, 唯一度, 经典算法, 引擎)
+//   经典算法: 只在 Insertion / Merge / Quick 中选，供 KNNOptimizer 使用
+//             (Quick 指末元素做枢轴的 Lomuto 快排，有序、逆序与大量重复时退化为 O(N^2))
+//   引擎:     CLI/GUI SortingEngine 的完整引擎集，供 KnnSelector 使用
+// 距离按 log10(规模) / 7 归一化，两个模块一致
+//
+// 使用方先定义 KNN_SAMPLE 再包含本文件；本文件故意不设 include guard
+
+// 1. 极小数据集 -> Insertion Sort (引擎: 排序网络 / 单趟反转)
+KNN_SAMPLE(30, 0.10, 0.10, 1.00, INSERTION_SORT, BLOCK_QUICK_SORT)
+KNN_SAMPLE(50, 0.90, 0.00, 1.00, INSERTION_SORT, INSERTION_SORT)
+KNN_SAMPLE(20, 0.00, 1.00, 1.00, INSERTION_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(40, 0.00, 0.90, 1.00, INSERTION_SORT, RUN_MERGE_SORT)
+
+// 2. 随机数据 -> Quick Sort (引擎: 小规模归并，大规模向量划分 / 基数排序)
+KNN_SAMPLE(100, 0.50, 0.50, 1.00, QUICK_SORT, MERGE_SORT)
+KNN_SAMPLE(1000, 0.50, 0.50, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(2000, 0.50, 0.50, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(5000, 0.40, 0.40, 0.90, QUICK_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(10000, 0.50, 0.50, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(100000, 0.50, 0.50, 1.00, QUICK_SORT, RADIX_SORT)
+KNN_SAMPLE(1000000, 0.50, 0.50, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+
+// 3. 几乎有序 -> Insertion Sort，仅当几乎每一对都有序；否则按随机处理
+//    引擎: 少量降序处切出的有序段交给 Run Merge
+KNN_SAMPLE(100, 1.00, 0.00, 1.00, INSERTION_SORT, INSERTION_SORT)
+KNN_SAMPLE(500, 0.95, 0.00, 1.00, INSERTION_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(1000, 0.99, 0.01, 1.00, INSERTION_SORT, INSERTION_SORT)
+KNN_SAMPLE(1000, 0.90, 0.10, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(100000, 0.90, 0.10, 1.00, QUICK_SORT, VECTOR_QUICK_SORT)
+
+// 4. 逆序 -> Merge Sort (Lomuto 快排在逆序上是 O(N^2))
+//    引擎: 一条降序段由 Run Merge 一趟反转；带少量升序时交给向量划分
+KNN_SAMPLE(100, 0.00, 1.00, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(500, 0.00, 0.95, 1.00, MERGE_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(1000, 0.00, 1.00, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(2000, 0.00, 0.99, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(5000, 0.00, 1.00, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(10000, 0.00, 1.00, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+KNN_SAMPLE(1000000, 0.00, 1.00, 1.00, MERGE_SORT, RUN_MERGE_SORT)
+
+// 5. 重复元素多 -> Merge Sort (引擎: 向量划分一趟丢掉一段相等键)
+KNN_SAMPLE(800, 0.20, 0.20, 0.20, MERGE_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(1000, 0.30, 0.30, 0.05, MERGE_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(1000, 0.60, 0.60, 0.01, MERGE_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(5000, 0.50, 0.20, 0.10, MERGE_SORT, VECTOR_QUICK_SORT)
+KNN_SAMPLE(100000, 0.60, 0.60, 0.01, MERGE_SORT, VECTOR_QUICK_SORT)
@@ -0,0 +1,147 @@
+// Selector.cpp
+#include "Selector.h"
+#include "AI_Optimizer.h"
+#include "KNN_Optimizer.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+AlgorithmType RuleSelector::predict(const DatasetFeatures& features) const {
+    return AIOptimizer::predict(features);
+}
+
+AlgorithmType KnnSelector::predict(const DatasetFeatures& features) const {
+    // 知识库只在第一次使用时构建一次
+    static const KNNOptimizer knn;
+    return knn.predict(features, 5, false);
+}
+
+// ---------------------------------------------------------
+// 代价模型 (单位：每个元素的比较/移动次数，已乘常数)
+// ---------------------------------------------------------
+double CostModelSelector::estimate(AlgorithmType algo, const DatasetFeatures& f) {
+    double n = std::max(f.size, 2);
+    double levels = std::log2(n);
+
+    switch (algo) {
+        case INSERTION_SORT:
+            // 每个元素平均移动 n * (1 - 有序度) / 2 次：随机 n/4，逆序 n/2
+            return 1.0 + n * (1.0 - f.sortednessRatio) / 2.0;
+        case MERGE_SORT:
+            // 稳定 log n 层，每层复制进临时数组，常数约为快排的 2 倍
+            return 2.0 * levels;
+        case QUICK_SORT: {
+            // Lomuto 分区取末尾为枢轴：有序/逆序时每层只去掉一个元素，
+            // 重复值全部落在同一侧，两者都向 n/2 退化
+            double ordered = std::max(f.sortednessRatio, f.reversedRatio);
+            double degenerate = std::max(0.0, (ordered - 0.9) * 10.0) + std::max(0.0, 0.4 - f.uniqueRatio);
+            return 1.4 * levels + degenerate * n / 2.0;
+        }
+        default:
+            return 1e18;
+    }
+}
+
+AlgorithmType CostModelSelector::predict(const DatasetFeatures& features) const {
+    AlgorithmType best = MERGE_SORT;
+    for (AlgorithmType algo : {INSERTION_SORT, QUICK_SORT}) {
+        if (estimate(algo, features) < estimate(best, features)) best = algo;
+    }
+    return best;
+}
+
+// ---------------------------------------------------------
+// 预编译决策表
+// ---------------------------------------------------------
+TableSelector::TableSelector(std::unique_ptr<Selector> source)
+    : source(std::move(source)), table(SIZE_CELLS << (3 * RATIO_BITS)) {
+    for (int cell = 0; cell < (int)table.size(); cell++) {
+        table[cell] = (unsigned char)this->source->predict(cellPoint(cell, 0.5, 0.5, 0.5, 0.5));
+    }
+    std::vector<int> disagreeing = check();
+    for (int cell : disagreeing) repair(cell);
+    repaired = (int)disagreeing.size();
+    if (repaired > 0) check();
+    if (agreed < MIN_AGREEMENT) {
+        throw std::runtime_error("Decision table for " + this->source->name() + " agrees with it on only "
+                                 + std::to_string((int)(agreed * 1000) / 10.0) + "% of the test points");
+    }
+}
+
+AlgorithmType TableSelector::predict(const DatasetFeatures& features) const {
+    return (AlgorithmType)table[(sizeCell(features.size) << (3 * RATIO_BITS)) | features.ratioCells];
+}
+
+// 高位是倍频程 (最高位的位置)，低两位是最高位之后的两位
+int TableSelector::sizeCell(int size) {
+    uint32_t n = (uint32_t)std::max(size, 1);
+    int octave = 31 - __builtin_clz(n);
+    return (octave << 2) | (int)((((uint64_t)n << 2) >> octave) & 3);
+}
+
+// 格内各维按比例 (0..1) 取的点；0.5 即格子中心
+DatasetFeatures TableSelector::cellPoint(int cell, double atSize, double atSorted, double atReversed, double atUnique) {
+    int mask = RATIO_CELLS - 1;
+    int sizeIndex = cell >> (3 * RATIO_BITS);
+    double size = std::ldexp(1.0 + ((sizeIndex & 3) + atSize) / 4, sizeIndex >> 2);
+    return point((int)std::min(size, (double)INT_MAX), (((cell >> (2 * RATIO_BITS)) & mask) + atSorted) / RATIO_CELLS,
+                 (((cell >> RATIO_BITS) & mask) + atReversed) / RATIO_CELLS, ((cell & mask) + atUnique) / RATIO_CELLS);
+}
+
+DatasetFeatures TableSelector::point(int size, double sorted, double reversed, double unique) {
+    return {size, sorted, reversed, unique, size > 1000, quantiseRatios(sorted, reversed, unique)};
+}
+
+// 测试点：规模 10 .. 10^7 每十倍取三档，三个比例各取五档 (都不在格子中心)
+// 返回出现不一致的格子
+std::vector<int> TableSelector::check() {
+    const double levels[] = {0.03, 0.2, 0.45, 0.7, 0.97};
+    std::vector<int> disagreeing;
+    int agree = 0;
+    points = 0;
+    for (double size = 10; size <= 1e7; size *= 2.154) {
+        for (double sorted : levels) {
+            for (double reversed : levels) {
+                for (double unique : levels) {
+                    DatasetFeatures f = point((int)size, sorted, reversed, unique);
+                    if (predict(f) == source->predict(f)) {
+                        agree++;
+                    } else {
+                        disagreeing.push_back((sizeCell(f.size) << (3 * RATIO_BITS)) | f.ratioCells);
+                    }
+                    points++;
+                }
+            }
+        }
+    }
+    agreed = (double)agree / points;
+    std::sort(disagreeing.begin(), disagreeing.end());
+    disagreeing.erase(std::unique(disagreeing.begin(), disagreeing.end()), disagreeing.end());
+    return disagreeing;
+}
+
+// 格内每维 4 个点、共 256 个点上源模型的多数票
+void TableSelector::repair(int cell) {
+    int votes[QUICK_SORT + 1] = {};
+    for (int i = 0; i < 256; i++) {
+        DatasetFeatures f = cellPoint(cell, ((i & 3) + 0.5) / 4, (((i >> 2) & 3) + 0.5) / 4,
+                                      (((i >> 4) & 3) + 0.5) / 4, ((i >> 6) + 0.5) / 4);
+        votes[source->predict(f)]++;
+    }
+    table[cell] = (unsigned char)(std::max_element(votes, votes + QUICK_SORT + 1) - votes);
+}
+
+const std::vector<std::string>& selectorNames() {
+    static const std::vector<std::string> names = {"rules", "knn", "cost", "table"};
+    return names;
+}
+
+std::unique_ptr<Selector> makeSelector(const std::string& name) {
+    if (name == "rules") return std::unique_ptr<Selector>(new RuleSelector());
+    if (name == "knn") return std::unique_ptr<Selector>(new KnnSelector());
+    if (name == "cost") return std::unique_ptr<Selector>(new CostModelSelector());
+    if (name == "table") return std::unique_ptr<Selector>(new TableSelector(makeSelector("knn")));
+    throw std::invalid_argument("Unknown selector: " + name);
+}
@@ -0,0 +1,82 @@
+#ifndef SELECTOR_H
+#define SELECTOR_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Sort_Types.h"
+
+// 统一的选择器接口：所有策略读同一个 DatasetFeatures，可以在同一个程序里互换或做 A/B 对比
+class Selector {
+public:
+    virtual ~Selector() = default;
+    virtual std::string name() const = 0;
+    virtual AlgorithmType predict(const DatasetFeatures& features) const = 0;
+};
+
+// 规则 (决策树)：AIOptimizer::predict
+class RuleSelector : public Selector {
+public:
+    std::string name() const override { return "rules"; }
+    AlgorithmType predict(const DatasetFeatures& features) const override;
+};
+
+// 加权 k-NN：KNNOptimizer::predict (不打印近邻)
+class KnnSelector : public Selector {
+public:
+    std::string name() const override { return "knn"; }
+    AlgorithmType predict(const DatasetFeatures& features) const override;
+};
+
+// 代价模型：按复杂度估算每个元素的比较/移动次数，取最小者
+class CostModelSelector : public Selector {
+public:
+    std::string name() const override { return "cost"; }
+    AlgorithmType predict(const DatasetFeatures& features) const override;
+
+    // 估算每个元素的代价 (冒泡不参与，返回极大值)
+    static double estimate(AlgorithmType algo, const DatasetFeatures& features);
+};
+
+// 预编译决策表：构造时 (加载时) 对网格每个格子的中心点调用一次源模型，
+// 网格维度为 log2(size) (按 1/4 倍频程) x 有序度 x 逆序度 x 唯一度 (各 8 档)。
+// 之后每次预测只需一次 clz、几次移位和一次查表，没有浮点运算
+// (三个比例已在提取特征时量化进 ratioCells)。
+// 只适用于只读这四个特征的源模型 (如 k-NN)；构造后在一组避开格子中心的
+// 测试点上与源模型逐点比对，不一致的格子改用格内 4x4x4x4 个点的多数票；
+// 修复后一致率仍低于 MIN_AGREEMENT 时抛出 std::runtime_error。
+class TableSelector : public Selector {
+public:
+    static constexpr int SIZE_CELLS = 4 * 32;   // 1 .. 2^32，每倍频程 4 格
+    static constexpr int RATIO_CELLS = 1 << RATIO_BITS;
+    static constexpr double MIN_AGREEMENT = 0.97;
+
+    explicit TableSelector(std::unique_ptr<Selector> source);
+
+    std::string name() const override { return source->name() + "+table"; }
+    AlgorithmType predict(const DatasetFeatures& features) const override;
+
+    int cells() const { return (int)table.size(); }
+    int testPoints() const { return points; }
+    double agreement() const { return agreed; }
+    int repairedCells() const { return repaired; }
+
+private:
+    std::unique_ptr<Selector> source;
+    std::vector<unsigned char> table;
+    int points = 0;
+    double agreed = 0;
+    int repaired = 0;
+
+    static int sizeCell(int size);
+    static DatasetFeatures cellPoint(int cell, double atSize, double atSorted, double atReversed, double atUnique);
+    static DatasetFeatures point(int size, double sorted, double reversed, double unique);
+    std::vector<int> check();
+    void repair(int cell);
+};
+
+// 按名字创建 ("rules" / "knn" / "cost" / "table")，未知名字抛出 std::invalid_argument
+std::unique_ptr<Selector> makeSelector(const std::string& name);
+const std::vector<std::string>& selectorNames();
+
+#endif // SELECTOR_H
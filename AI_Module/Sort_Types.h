@@ -0,0 +1,36 @@
+#ifndef SORT_TYPES_H
+#define SORT_TYPES_H
+
+// AI_Optimizer、KNN_Optimizer 与 Selector 共用的类型
+// (之前两个头文件各自定义一份且字段不同，无法链接进同一个程序)
+
+enum AlgorithmType {
+    BUBBLE_SORT,
+    INSERTION_SORT,
+    MERGE_SORT,
+    QUICK_SORT
+};
+
+// 特征结构体 (由 AIOptimizer::analyzeDataset 提取)
+struct DatasetFeatures {
+    int size;
+    double sortednessRatio;   // 0.0 - 1.0，相邻升序对占比
+    double reversedRatio;     // 0.0 - 1.0，相邻降序对占比
+    double uniqueRatio;       // 0.0 - 1.0，采样估算
+    bool isLargeDataset;
+    int ratioCells;           // 三个比例各按 1/8 量化 (各 3 位)：有序度 << 6 | 逆序度 << 3 | 唯一度
+};
+
+// 比例量化只在提取特征时做一次，决策表查表时不再碰浮点数
+constexpr int RATIO_BITS = 3;
+
+inline int ratioLevel(double ratio) {
+    int level = (int)(ratio * (1 << RATIO_BITS));
+    return level < 0 ? 0 : (level > (1 << RATIO_BITS) - 1 ? (1 << RATIO_BITS) - 1 : level);
+}
+
+inline int quantiseRatios(double sorted, double reversed, double unique) {
+    return (ratioLevel(sorted) << (2 * RATIO_BITS)) | (ratioLevel(reversed) << RATIO_BITS) | ratioLevel(unique);
+}
+
+#endif // SORT_TYPES_H
@@ -4,11 +4,43 @@
 #include <ctime>
 #include <algorithm> 
 #include <chrono>    // 用于高精度计时
+#include <thread>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <iomanip>
+#include <string>
 #include "AI_Optimizer.h"
+#include "Selector.h"
 
 using namespace std;
 using namespace std::chrono;
 
+// --- 0. 赛跑控制 (Racing) ---
+// 算法并发运行，按各线程自己的 CPU 时间比较 (不受调度先后影响)：
+// 有算法完成后，其余算法每 4096 次迭代检查一次，CPU 时间超过最快完成者即提前退出
+atomic<long long> bestCpuNs(LLONG_MAX);
+struct RaceLost {};
+thread_local long long raceTicks = 0;
+thread_local long long raceStartNs = 0;
+
+// 当前线程已消耗的 CPU 时间 (纳秒)；没有线程时钟的平台退回墙钟
+long long threadCpuNs() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline void checkRace() {
+    if ((++raceTicks & 4095) == 0 && bestCpuNs.load(memory_order_relaxed) != LLONG_MAX) {
+        if (threadCpuNs() - raceStartNs > bestCpuNs.load(memory_order_relaxed)) throw RaceLost();
+    }
+}
+
 // --- 1. 实际排序算法实现 (用于验证) ---
 
 void insertionSort(vector<int> arr) { // 传值，不破坏原数组
@@ -16,6 +48,7 @@ void insertionSort(vector<int> arr) { // 传值，不破坏原数组
         int key = arr[i];
         int j = i - 1;
         while (j >= 0 && arr[j] > key) {
+            checkRace();
             arr[j + 1] = arr[j];
             j--;
         }
@@ -30,7 +63,7 @@ void merge(vector<int>& arr, int l, int m, int r) {
     for(int i=0; i<n1; i++) L[i] = arr[l + i];
     for(int j=0; j<n2; j++) R[j] = arr[m + 1 + j];
     int i=0, j=0, k=l;
-    while(i<n1 && j<n2) arr[k++] = (L[i]<=R[j]) ? L[i++] : R[j++];
+    while(i<n1 && j<n2) { checkRace(); arr[k++] = (L[i]<=R[j]) ? L[i++] : R[j++]; }
     while(i<n1) arr[k++] = L[i++];
     while(j<n2) arr[k++] = R[j++];
 }
@@ -48,6 +81,7 @@ int partition(vector<int>& arr, int low, int high) {
     int pivot = arr[high];
     int i = (low - 1);
     for (int j = low; j <= high - 1; j++) {
+        checkRace();
         if (arr[j] < pivot) swap(arr[++i], arr[j]);
     }
     swap(arr[i + 1], arr[high]);
@@ -63,11 +97,59 @@ void quickSortRec(vector<int>& arr, int low, int high) {
 void quickSort(vector<int> arr) { quickSortRec(arr, 0, arr.size()-1); }
 
 // --- 2. 计时器工具 ---
-double measureTime(void (*sortFunc)(vector<int>), const vector<int>& data) {
-    auto start = high_resolution_clock::now();
-    sortFunc(data); // 运行排序
-    auto stop = high_resolution_clock::now();
-    return duration_cast<microseconds>(stop - start).count() / 1000.0; // 返回毫秒
+// 作用域结束时恢复 cout 的格式标志与精度 (fixed / setprecision 不外泄到后续报告)
+struct StreamFormat {
+    ios::fmtflags flags = cout.flags();
+    streamsize precision = cout.precision();
+    ~StreamFormat() {
+        cout.flags(flags);
+        cout.precision(precision);
+    }
+};
+
+struct RaceEntry {
+    string name;
+    void (*sortFunc)(vector<int>);
+    double timeMs;      // 完成耗时，或被淘汰前已运行的时间 (线程 CPU 时间)
+    bool finished;      // false 表示输掉比赛被提前终止
+};
+
+// 每轮参赛线程数不超过核心数，多出的算法进入下一轮，最快成绩跨轮保留；
+// 同一轮内所有线程复制完数据后才一起开跑
+void runRace(vector<RaceEntry>& entries, const vector<int>& data) {
+    bestCpuNs = LLONG_MAX;
+    size_t lanes = max(1u, thread::hardware_concurrency());
+    for (size_t first = 0; first < entries.size(); first += lanes) {
+        size_t heat = min(lanes, entries.size() - first);
+        atomic<size_t> ready(0);
+        atomic<bool> go(false);
+        vector<thread> runners;
+        for (size_t j = 0; j < heat; j++) {
+            RaceEntry& e = entries[first + j];
+            runners.emplace_back([&e, &data, &ready, &go]() {
+                vector<int> copy = data;
+                raceTicks = 0;
+                ready++;
+                while (!go) this_thread::yield();
+                raceStartNs = threadCpuNs();
+                try {
+                    e.sortFunc(move(copy));
+                    e.finished = true;
+                } catch (const RaceLost&) {
+                    e.finished = false;
+                }
+                long long used = threadCpuNs() - raceStartNs;
+                e.timeMs = used / 1e6; // CPU 毫秒
+                if (e.finished) {
+                    long long best = bestCpuNs.load();
+                    while (used < best && !bestCpuNs.compare_exchange_weak(best, used)) {}
+                }
+            });
+        }
+        while (ready < heat) this_thread::yield();
+        go = true;
+        for (auto& t : runners) t.join();
+    }
 }
 
 // --- 3. 生成器 ---
@@ -89,7 +171,31 @@ vector<int> generateNearlySorted(int size) {
 }
 
 // --- 4. 测试主逻辑 ---
-void runTestCase(string testName, vector<int>& data) {
+// 单个测试的结果: 是否猜中 + 后悔值 (预测算法耗时 / 最快算法耗时，1.0 表示最优)
+struct TestOutcome {
+    string type;
+    int size;
+    bool correct;
+    double regret;
+};
+
+// 单独重跑一个算法拿到完整耗时 (输掉比赛的算法被提前终止，没有完整时间)
+// 取 3 次中的最短时间，减少冷缓存与调度噪声
+double timeAlone(const RaceEntry& entry, const vector<int>& data) {
+    bestCpuNs = LLONG_MAX;
+    raceTicks = 0;
+    double bestMs = 1e18;
+    for (int rep = 0; rep < 3; rep++) {
+        vector<int> copy = data;
+        auto start = high_resolution_clock::now();
+        entry.sortFunc(move(copy));
+        auto stop = high_resolution_clock::now();
+        bestMs = min(bestMs, duration_cast<nanoseconds>(stop - start).count() / 1e6);
+    }
+    return bestMs;
+}
+
+TestOutcome runTestCase(string testName, vector<int>& data) {
     cout << "\n================================================" << endl;
     cout << "TEST: " << testName << " (Size=" << data.size() << ")" << endl;
     
@@ -101,37 +207,158 @@ void runTestCase(string testName, vector<int>& data) {
     // 2. 实际验证 (Benchmark)
     cout << "\n[Running Benchmark Validation...]" << endl;
     
-    // 如果数据量太大，跳过 O(n^2) 算法以节省时间
-    double timeIns = (data.size() > 10000 && features.sortednessRatio < 0.9) ? 9999.9 : measureTime(insertionSort, data);
-    double timeMerge = measureTime(mergeSort, data);
-    double timeQuick = measureTime(quickSort, data);
-
-    cout << "  > Insertion Sort: " << (timeIns > 9000 ? "Timeout (>10s)" : to_string(timeIns) + " ms") << endl;
-    cout << "  > Merge Sort:     " << timeMerge << " ms" << endl;
-    cout << "  > Quick Sort:     " << timeQuick << " ms" << endl;
+    // 赛跑模式: O(n^2) 算法在任何规模下都参赛，CPU 时间一旦超过最快完成者就会被提前终止
+    vector<RaceEntry> entries = {
+        {"Insertion Sort", insertionSort, 0.0, false},
+        {"Merge Sort",     mergeSort,     0.0, false},
+        {"Quick Sort",     quickSort,     0.0, false}
+    };
+    runRace(entries, data);
 
-    // 3. 结论判断
     string winner;
-    double minTime = min({timeIns, timeMerge, timeQuick});
-    
-    if (minTime == timeIns) winner = "Insertion Sort";
-    else if (minTime == timeMerge) winner = "Merge Sort";
-    else winner = "Quick Sort";
+    double minTime = 1e18;
+    for (const auto& e : entries) {
+        cout << "  > " << e.name << ": " << string(15 - e.name.size(), ' ');
+        if (e.finished) cout << e.timeMs << " ms CPU" << endl;
+        else cout << "Stopped after " << e.timeMs << " ms CPU (lost race)" << endl;
+
+        // 3. 结论判断
+        if (e.finished && e.timeMs < minTime) {
+            minTime = e.timeMs;
+            winner = e.name;
+        }
+    }
+
+    // 3. 后悔值: 每个算法各自单独重跑一次 (赛跑时多线程抢占，计时不可比)，
+    //    以单独运行最快者为基准，不做截断；冒泡不参赛，按插入排序计
+    int chosen = prediction == MERGE_SORT ? 1 : (prediction == QUICK_SORT ? 2 : 0);
+    vector<double> aloneMs;
+    for (const auto& e : entries) aloneMs.push_back(timeAlone(e, data));
+    int best = min_element(aloneMs.begin(), aloneMs.end()) - aloneMs.begin();
+    string aiChoice = AIOptimizer::getAlgorithmName(prediction);
+    double predictedMs = aloneMs[chosen], bestMs = aloneMs[best];
+    TestOutcome outcome = {testName, (int)data.size(), chosen == best, predictedMs / max(bestMs, 1e-6)};
 
+    StreamFormat format;
     cout << "------------------------------------------------" << endl;
-    cout << "Actual Winner: " << winner << endl;
+    cout << "Actual Winner: " << winner << " (race), " << entries[best].name << " (run alone)" << endl;
+    cout << "Regret: " << fixed << setprecision(2) << outcome.regret << "x ("
+         << aiChoice << " " << predictedMs << " ms vs " << bestMs << " ms)" << endl;
     
-    string aiChoice = AIOptimizer::getAlgorithmName(prediction);
-    if (aiChoice == winner) {
+    if (outcome.correct) {
         cout << "RESULT: [SUCCESS] AI prediction matches the fastest algorithm!" << endl;
     } else {
-        // 允许微小误差（例如快排和归并只差 0.1ms 算并列）
-        if (abs(timeMerge - timeQuick) < 0.5 && (prediction == MERGE_SORT || prediction == QUICK_SORT))
+        // 允许微小误差（例如快排和归并只差 0.5ms 算并列）
+        if (abs(predictedMs - bestMs) < 0.5)
              cout << "RESULT: [SUCCESS] Performance is practically identical." << endl;
         else 
              cout << "RESULT: [DIFF] Comparison complex, check characteristics." << endl;
     }
     cout << "================================================" << endl;
+    return outcome;
+}
+
+// --- 5. 网格汇总 ---
+// 一行统计: 猜中率、平均/几何平均后悔值、最差后悔值
+void printGridRow(const string& label, const vector<TestOutcome>& group) {
+    if (group.empty()) return;
+    int correct = 0;
+    double sum = 0, logSum = 0, worst = 0;
+    for (const auto& o : group) {
+        correct += o.correct;
+        sum += o.regret;
+        logSum += log(o.regret);
+        worst = max(worst, o.regret);
+    }
+    int n = group.size();
+    StreamFormat format;
+    cout << left << setw(16) << label << setw(7) << n << fixed << setprecision(0) << setw(10) << 100.0 * correct / n
+         << setprecision(3) << setw(9) << sum / n << setw(9) << exp(logSum / n) << worst << endl;
+}
+
+// 数据类型 x 规模 x 重复次数：每份数据把三种算法各单独跑一次，
+// 所有选择器 (rules / knn / cost) 用同一组计时打分，做 A/B 对比
+void runGrid(int seeds) {
+    vector<pair<string, vector<int> (*)(int)>> types = {
+        {"Random", generateRandom}, {"Reversed", generateReversed}, {"Nearly Sorted", generateNearlySorted}
+    };
+    vector<int> sizes = {20, 200, 2000, 5000};
+    vector<RaceEntry> algos = {
+        {"Insertion Sort", insertionSort, 0.0, false},
+        {"Merge Sort",     mergeSort,     0.0, false},
+        {"Quick Sort",     quickSort,     0.0, false}
+    };
+    vector<unique_ptr<Selector>> selectors;
+    for (const auto& name : selectorNames()) selectors.push_back(makeSelector(name));
+    for (const auto& selector : selectors) {
+        // 决策表在构造时已与源模型逐点比对
+        if (auto table = dynamic_cast<const TableSelector*>(selector.get())) {
+            StreamFormat format;
+            cout << "Decision table " << table->name() << ": " << table->cells() << " cells, agrees with the source on "
+                 << fixed << setprecision(1) << table->agreement() * 100 << "% of " << table->testPoints()
+                 << " test points (" << table->repairedCells() << " cells rebuilt by majority vote)" << endl;
+        }
+    }
+
+    vector<vector<TestOutcome>> outcomes(selectors.size());
+    vector<double> elements(selectors.size(), 0), sortMs(selectors.size(), 0);
+    vector<DatasetFeatures> caseFeatures;
+    for (const auto& t : types) {
+        for (int size : sizes) {
+            for (int s = 0; s < seeds; s++) {
+                vector<int> data = t.second(size);
+                DatasetFeatures features = AIOptimizer::analyzeDataset(data.data(), data.size());
+                caseFeatures.push_back(features);
+                vector<double> ms;
+                for (const auto& a : algos) ms.push_back(timeAlone(a, data));
+                int best = min_element(ms.begin(), ms.end()) - ms.begin();
+
+                for (size_t i = 0; i < selectors.size(); i++) {
+                    // 冒泡不参赛，按插入排序计
+                    AlgorithmType pick = selectors[i]->predict(features);
+                    int chosen = pick == MERGE_SORT ? 1 : (pick == QUICK_SORT ? 2 : 0);
+                    outcomes[i].push_back({t.first, size, chosen == best, ms[chosen] / max(ms[best], 1e-6)});
+                    elements[i] += size;
+                    sortMs[i] += ms[chosen];
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < selectors.size(); i++) {
+        cout << "\n=============== Regret Grid: " << selectors[i]->name() << " (" << outcomes[i].size()
+             << " cases) ===============" << endl;
+        cout << left << setw(16) << "Group" << setw(7) << "Cases" << setw(10) << "Exact %"
+             << setw(9) << "Mean" << setw(9) << "GeoMean" << "Worst" << endl;
+        for (const auto& t : types) {
+            vector<TestOutcome> group;
+            for (const auto& o : outcomes[i]) if (o.type == t.first) group.push_back(o);
+            printGridRow(t.first, group);
+        }
+        for (int size : sizes) {
+            vector<TestOutcome> group;
+            for (const auto& o : outcomes[i]) if (o.size == size) group.push_back(o);
+            printGridRow("n = " + to_string(size), group);
+        }
+        printGridRow("All", outcomes[i]);
+    }
+
+    // A/B: 同一批数据上各选择器的总吞吐量 (百万元素/秒)，以及单次 predict 的平均耗时
+    cout << "\n=============== A/B Throughput ===============" << endl;
+    StreamFormat format;
+    int rounds = max(1, 200000 / (int)caseFeatures.size());
+    for (size_t i = 0; i < selectors.size(); i++) {
+        volatile int sink = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (const auto& f : caseFeatures) sink = sink + selectors[i]->predict(f);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double predictNs = chrono::duration<double, nano>(end - start).count() / ((double)rounds * caseFeatures.size());
+        cout << left << setw(16) << selectors[i]->name() << fixed << setprecision(2)
+             << elements[i] / sortMs[i] / 1000.0 << " M elements/s, predict " << setprecision(1) << predictNs
+             << " ns" << endl;
+    }
 }
 
 int main() {
@@ -155,5 +382,14 @@ int main() {
     vector<int> small = generateRandom(20);
     runTestCase("Tiny Dataset", small);
 
+    // 网格: 每种数据 x 每个规模跑 3 次
+    // 决策表与源模型一致率不达标时构造会抛异常，以非零状态退出
+    try {
+        runGrid(3);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+
     return 0;
 }
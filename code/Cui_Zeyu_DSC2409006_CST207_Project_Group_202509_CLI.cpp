@@ -1,14 +1,13 @@
 /*
  * AI-Driven Sorting Algorithm Optimizer - Command Line Interface
- * g++ Cui_Zeyu_DSC2409006_CST207_Project_Group_202509_CLI.cpp -o SortingAlgorithmOptimizerCLI -std=c++11
- * ./SortingAlgorithmOptimizerCLI
+ * g++ Cui_Zeyu_DSC2409006_CST207_Project_Group_202509_CLI.cpp -o SortingAlgorithmOptimizerCLI -std=c++11 -pthread
+ * ./SortingAlgorithmOptimizerCLI [--seed N] [--parallel | --race] [--dataset NAME --size N] [--save FILE | --load FILE]
  */
 
 #include <iostream>
 #include <vector>
 #include <string>
 #include <chrono>
-#include <unordered_set>
 #include <algorithm>
 #include <random>
 #include <ctime>
@@ -16,6 +15,54 @@
 #include <iomanip>
 #include <cmath>
 #include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <climits>
+#include <memory>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+// x86 builds with GCC/Clang get the AVX2 kernels, compiled per function and
+// picked at run time, so the binary still runs on CPUs without AVX2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SORTING_X86_SIMD 1
+#define SORTING_AVX2 __attribute__((target("avx2")))
+#define SORTING_AVX512 __attribute__((target("avx512f")))
+#endif
+
+// Optional: -DHAVE_LIBNUMA (link -lnuma) binds the NUMA sort's buffers to
+// their nodes; without it placement relies on first touch
+#if defined(HAVE_LIBNUMA)
+#include <numa.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Distinct-value counting, shared with the AI module
+#include "../AI_Module/HyperLogLog.h"
 
 using namespace std;
 
@@ -25,11 +72,39 @@ enum AlgoType {
     BUBBLE_SORT,
     INSERTION_SORT,
     MERGE_SORT,
-    QUICK_SORT
+    QUICK_SORT,
+    PREFIX_MERGE,           // Sort the unsorted tail, merge it into the sorted prefix
+    RADIX_SORT,             // LSD byte radix sort (no comparisons)
+    BLOCKED_MERGE_SORT,     // Merge sort tiled to the L1/L2 sizes, k-way merge on top
+    BLOCK_QUICK_SORT,       // Quick sort with a branch-free block partition
+    BRANCHLESS_MERGE_SORT,  // Bottom-up merge sort whose merge selects without branching
+    VECTOR_QUICK_SORT,      // Quick sort with an AVX2/AVX-512 partition
+    RUN_MERGE_SORT,         // Natural merge sort over the runs already in the input
+    COUNTING_SORT,          // One count per key value (dense key ranges)
+    HEAP_SELECT,            // Top-k: bounded max-heap
+    INTRO_SELECT,           // Top-k: quickselect with a heap fallback
+    RADIX_SELECT,           // Top-k: byte histograms
+    ALGO_TYPE_COUNT
+};
+
+// Dataset shapes offered by the generators (order matches the menus)
+enum DatasetType {
+    RANDOM_DATA,
+    NEARLY_SORTED_DATA,
+    REVERSED_DATA,
+    FEW_UNIQUE_DATA,
+    LARGE_RANDOM_DATA,
+    ORGAN_PIPE_DATA,
+    SAWTOOTH_DATA,
+    ZIPF_DATA,
+    GAUSSIAN_DATA,
+    SORTED_TAIL_DATA,
+    QUICKSORT_KILLER_DATA,
+    MOSTLY_EQUAL_DATA,
+    DATASET_TYPE_COUNT
 };
 
 struct DatasetFeatures {
-    vector<int> data;
     int size;
     double sortedness;      // 0.0 (random) to 1.0 (sorted)
     int uniqueCount;        // Number of unique elements
@@ -37,25 +112,447 @@ struct DatasetFeatures {
     double reversedness;    // Degree of reverse order (0.0 ~ 1.0)
     double uniqueRatio;     // Ratio of unique elements (0.0 ~ 1.0)
     bool isLargeDataset;    // Large dataset indicator (>1000)
+    int minValue;           // Smallest element
+    int maxValue;           // Largest element
+    int sortedPrefixLength; // Length of the longest non-decreasing prefix
+    int runs;               // Maximal non-decreasing or strictly decreasing runs
+    int longestRun;         // Length of the longest of those runs
+    double inversionRatio;  // Share of pairs i < j with data[i] > data[j] (sampled)
+    double remRatio;        // Share of elements off a longest sorted subsequence (sampled)
+    double entropyBits;     // Entropy of the key distribution (sampled, at most log2 of the sample)
+    int rangeBits;          // Bits needed for maxValue - minValue
+    int ratioCells;         // Sortedness, reversedness, uniqueness in eighths, 3 bits each (table lookups)
 };
 
 struct SortMetrics {
     long long comparisons = 0;      // Number of comparisons
     double executionTimeMs = 0.0;   // Execution time in milliseconds
-    string algoName;
+    AlgoType algo = ALGO_TYPE_COUNT; // Algorithm that ran (named by SortingEngine::getAlgoName)
+    bool cancelled = false;         // Stopped before finishing (time is partial)
+    long long heapAllocations = 0;  // Global operator new calls made by the run
+    double startedAtMs = 0.0;       // Start time on the steady clock (for overlap checks)
+    int core = -1;                  // Core the run was pinned to (-1 = not pinned)
+    double overlapMs = 0.0;         // Time spent running alongside other candidates
+};
+
+// Records stored as a struct of arrays: one int key column and any number of
+// fixed-width payload columns (column c holds size() * widths[c] bytes)
+struct RecordTable {
+    vector<int> keys;
+    vector<vector<unsigned char> > columns;
+    vector<size_t> widths;
+
+    int size() const { return (int)keys.size(); }
+
+    size_t payloadBytes() const {
+        size_t total = 0;
+        for (size_t w : widths) total += w;
+        return total;
+    }
+};
+
+// How a record sort is carried out (chosen by SortingEngine::predictRecordPlan)
+struct RecordPlan {
+    AlgoType algo;          // Kernel run over the packed 64-bit words
+    bool inlinePayload;     // Pack (key, payload) and skip the gather (payload <= 4 bytes)
+};
+
+// Data cache sizes in bytes (see SortingEngine::cacheSizes)
+struct CacheSizes {
+    size_t l1;
+    size_t l2;
+    size_t l3;
+};
+
+// Thrown by the sorting kernels when the run's cancellation flag is raised
+class SortCancelled : public runtime_error {
+public:
+    SortCancelled() : runtime_error("Sort cancelled") {}
+};
+
+// ============= Random Number Generation =============
+
+// xoshiro256** generator seeded through splitmix64.
+// Every (seed, stream) pair yields its own sequence, so each thread or chunk
+// can draw from a private stream and results never depend on scheduling.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (int i = 0; i < 4; i++) s[i] = splitMix64(x);
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound) without modulo bias (Lemire's multiply-shift)
+    uint32_t below(uint32_t bound) {
+        uint64_t m = (next() >> 32) * bound;
+        uint32_t low = (uint32_t)m;
+        if (low < bound) {
+            uint32_t threshold = (uint32_t)(-bound) % bound;
+            while (low < threshold) {
+                m = (next() >> 32) * bound;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // Uniform double in [0, 1)
+    double uniform() {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static uint64_t splitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+// ============= Scratch Memory =============
+
+// Global operator new calls made by each thread. The replacements below
+// count them, so the difference across a request is the number of heap
+// allocations it made (SortMetrics::heapAllocations).
+static thread_local long long threadHeapAllocations = 0;
+
+long long heapAllocations() { return threadHeapAllocations; }
+
+// Every form is replaced (plain, nothrow, array and sized), so whichever one
+// the library allocates with is released by the matching malloc/free pair:
+// std::stable_partition's buffer comes from the nothrow new, and a sanitizer
+// reports a mismatch if only the plain forms are ours. All kept out of line:
+// inlined into a new or delete expression, the malloc and free inside look
+// mismatched with it to GCC's warnings.
+#if defined(__GNUC__)
+#define SORTING_NOINLINE __attribute__((noinline))
+#else
+#define SORTING_NOINLINE
+#endif
+
+SORTING_NOINLINE void* operator new(size_t bytes) {
+    threadHeapAllocations++;
+    if (void* p = malloc(bytes ? bytes : 1)) return p;
+    throw bad_alloc();
+}
+
+SORTING_NOINLINE void* operator new(size_t bytes, const nothrow_t&) noexcept {
+    threadHeapAllocations++;
+    return malloc(bytes ? bytes : 1);
+}
+
+SORTING_NOINLINE void* operator new[](size_t bytes) { return operator new(bytes); }
+SORTING_NOINLINE void* operator new[](size_t bytes, const nothrow_t& tag) noexcept { return operator new(bytes, tag); }
+
+SORTING_NOINLINE void operator delete(void* p) noexcept { free(p); }
+SORTING_NOINLINE void operator delete(void* p, const nothrow_t&) noexcept { free(p); }
+SORTING_NOINLINE void operator delete(void* p, size_t) noexcept { free(p); }
+SORTING_NOINLINE void operator delete[](void* p) noexcept { free(p); }
+SORTING_NOINLINE void operator delete[](void* p, const nothrow_t&) noexcept { free(p); }
+SORTING_NOINLINE void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// Per-thread monotonic arena for the temporary storage of the sorting
+// pipeline: merge and radix buffers, count tables, feature samples and the
+// k-NN distances. allocate() bumps an offset into the current block, and a
+// Scope puts the offset back where it found it, so nested users (merge
+// sort's recursion, the prefix merge sorting its tail) reuse the same bytes.
+// When the outermost Scope ends the blocks are folded into one and kept: a
+// thread that has served a request of n elements serves later ones up to
+// that size without touching the heap. Past KEEP_BYTES the memory is
+// returned instead, since a huge sort is not worth pinning for good.
+class ScratchArena {
+public:
+    static const size_t ALIGNMENT = 64;                 // Cache line, and one AVX-512 vector
+    static const size_t MIN_BLOCK = 64 * 1024;
+    static const size_t KEEP_BYTES = (size_t)256 << 20;
+
+    static ScratchArena& local() {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+    // Uninitialised room for `count` elements, valid until the innermost
+    // enclosing Scope ends
+    template <typename T>
+    T* allocate(size_t count) {
+        size_t bytes = count * sizeof(T);
+        size_t offset = blocks.empty() ? 0 : alignedOffset();
+        if (blocks.empty() || offset + bytes > blocks[current].size) {
+            nextBlock(bytes);
+            offset = alignedOffset();
+        }
+        used = offset + bytes;
+        return reinterpret_cast<T*>(blocks[current].data.get() + offset);
+    }
+
+    // Bytes held across all blocks
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Block& block : blocks) total += block.size;
+        return total;
+    }
+
+    // Everything allocated while a Scope is alive is released when it ends
+    class Scope {
+    public:
+        Scope() : arena(local()), block(arena.current), used(arena.used) { arena.depth++; }
+        ~Scope() {
+            arena.current = block;
+            arena.used = used;
+            if (--arena.depth == 0) arena.fold();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        ScratchArena& arena;
+        size_t block;
+        size_t used;
+    };
+
+private:
+    struct Block {
+        unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    vector<Block> blocks;
+    size_t current = 0;     // Block being bumped (blocks after it are free)
+    size_t used = 0;        // Bytes used in it
+    int depth = 0;          // Open Scopes
+
+    size_t alignedOffset() const {
+        uintptr_t base = (uintptr_t)blocks[current].data.get();
+        return ((base + used + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1)) - base;
+    }
+
+    // Move on to a free block with room for `bytes`, growing the arena
+    // geometrically when the next one is too small
+    void nextBlock(size_t bytes) {
+        size_t need = bytes + ALIGNMENT;
+        size_t next = blocks.empty() ? 0 : current + 1;
+        if (next >= blocks.size() || blocks[next].size < need) {
+            Block block;
+            block.size = need > MIN_BLOCK ? need : (size_t)MIN_BLOCK;
+            block.size = block.size > capacity() ? block.size : capacity();
+            block.data.reset(new unsigned char[block.size]);
+            if (next < blocks.size()) blocks[next] = move(block);
+            else blocks.push_back(move(block));
+        }
+        current = next;
+        used = 0;
+    }
+
+    // Nothing is in use: fold the blocks into one (or let go of them)
+    void fold() {
+        size_t total = capacity();
+        if (total > KEEP_BYTES) {
+            blocks.clear();
+        } else if (blocks.size() > 1) {
+            // This runs from ~Scope, so it must not throw: get the merged
+            // block first, and keep the blocks we have if it is refused
+            unsigned char* merged = new (nothrow) unsigned char[total];
+            if (merged) {
+                blocks.clear();
+                Block block;
+                block.size = total;
+                block.data.reset(merged);
+                blocks.push_back(move(block));  // Reuses the cleared vector's room
+            }
+        }
+        current = 0;
+        used = 0;
+    }
+};
+
+// ============= K-way Merge =============
+
+// Loser (tournament) tree over k sorted sources. Each internal node keeps
+// the loser of its match, so replacing the winner costs log2(k) comparisons.
+// Exhausted sources are given the key EXHAUSTED, which loses every match.
+// The nodes live in the thread's ScratchArena, so the tree must not outlive
+// the Scope it was built in.
+class LoserTree {
+public:
+    static const long long EXHAUSTED = LLONG_MAX;
+
+    LoserTree(const long long* initialKeys, int k)
+        : k(k), tree(ScratchArena::local().allocate<int>(max(k, 1))),
+          keys(ScratchArena::local().allocate<long long>(k + 1)) {
+        fill_n(tree, max(k, 1), k);
+        copy(initialKeys, initialKeys + k, keys);
+        keys[k] = LLONG_MIN;            // Virtual leaf k beats everything during build
+        for (int i = k - 1; i >= 0; i--) adjust(i);
+    }
+
+    int winner() const { return tree[0]; }
+    long long winnerKey() const { return keys[tree[0]]; }
+
+    // Give the current winner's source its next key (or EXHAUSTED) and replay
+    void replaceWinner(long long key) {
+        keys[tree[0]] = key;
+        adjust(tree[0]);
+    }
+
+private:
+    int k;
+    int* tree;              // tree[0] = winner, tree[1..k-1] = losers
+    long long* keys;        // Current head key of each source
+
+    void adjust(int s) {
+        for (int t = (s + k) / 2; t > 0; t /= 2) {
+            if (keys[s] > keys[tree[t]]) swap(s, tree[t]);
+        }
+        tree[0] = s;
+    }
+};
+
+// ============= Hardware Counters =============
+
+// One hardware event of the calling thread (user space only) through
+// perf_event_open. When the kernel or the platform does not allow it,
+// available() is false and read() returns -1.
+class PerfCounter {
+public:
+    PerfCounter(uint32_t type, uint64_t config) : fd(-1) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)type;
+        (void)config;
+#endif
+    }
+
+    ~PerfCounter() {
+#if defined(__linux__)
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    PerfCounter(PerfCounter&& other) : fd(other.fd) { other.fd = -1; }
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    static PerfCounter branchMisses() {
+#if defined(__linux__)
+        return PerfCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+        return PerfCounter(0, 0);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#if defined(__linux__)
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    // Stop counting and return the count since start()
+    long long read() {
+#if defined(__linux__)
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (::read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd;
 };
 
 // ============= Sorting Algorithm Implementations =============
 
 class SortingEngine {
 public:
+    // ============= Cancellation =============
+
+    static const long long CANCEL_CHECK_MASK = 4095;   // Poll every 4096 comparisons
+
+    // Cancellation flag of the run executing on this thread (nullptr = none)
+    static const atomic<bool>*& cancelFlag() {
+        thread_local const atomic<bool>* flag = nullptr;
+        return flag;
+    }
+
+    // Race-over flag of the run executing on this thread (nullptr = not racing)
+    static const atomic<bool>*& raceFlag() {
+        thread_local const atomic<bool>* flag = nullptr;
+        return flag;
+    }
+
+    // Throw SortCancelled if the current run has been asked to stop
+    // or has lost its race
+    static void checkCancel(long long comparisons) {
+        if ((comparisons & CANCEL_CHECK_MASK) == 0) {
+            const atomic<bool>* flag = cancelFlag();
+            const atomic<bool>* race = raceFlag();
+            if ((flag && flag->load(memory_order_relaxed)) ||
+                (race && race->load(memory_order_relaxed))) {
+                throw SortCancelled();
+            }
+        }
+    }
+
+    // ============= Element Keys =============
+    // The kernels are templates over the element type: plain int keys, or
+    // packed 64-bit (key, index) pairs for argsort and record sorts.
+
+    // Pack a key and a row index so that unsigned 64-bit order is key order,
+    // with ties broken by index (the sign bit is flipped so negatives come first)
+    static uint64_t packPair(int key, uint32_t index) {
+        return ((uint64_t)((uint32_t)key ^ 0x80000000u) << 32) | index;
+    }
+
+    static int keyOf(int value) { return value; }
+    static int keyOf(uint64_t pair) { return (int)((uint32_t)(pair >> 32) ^ 0x80000000u); }
+
+    // Unsigned bit pattern with the same order as the element (for radix passes)
+    static uint32_t radixBits(int value) { return (uint32_t)value ^ 0x80000000u; }
+    static uint64_t radixBits(uint64_t pair) { return pair; }
+
     // Bubble Sort Implementation
-    static void bubbleSort(vector<int>& arr, long long& comparisons) {
-        int n = arr.size();
+    template <typename T>
+    static void bubbleSort(T* arr, int n, long long& comparisons) {
         for (int i = 0; i < n - 1; i++) {
             bool swapped = false;
             for (int j = 0; j < n - i - 1; j++) {
                 comparisons++;
+                checkCancel(comparisons);
                 if (arr[j] > arr[j + 1]) {
                     swap(arr[j], arr[j + 1]);
                     swapped = true;
@@ -66,13 +563,14 @@ public:
     }
 
     // Insertion Sort Implementation
-    static void insertionSort(vector<int>& arr, long long& comparisons) {
-        int n = arr.size();
+    template <typename T>
+    static void insertionSort(T* arr, int n, long long& comparisons) {
         for (int i = 1; i < n; i++) {
-            int key = arr[i];
+            T key = arr[i];
             int j = i - 1;
             while (j >= 0) {
                 comparisons++;
+                checkCancel(comparisons);
                 if (arr[j] <= key) break;
                 arr[j + 1] = arr[j];
                 j--;
@@ -82,10 +580,13 @@ public:
     }
 
     // Merge function for Merge Sort
-    static void merge(vector<int>& arr, int l, int m, int r, long long& comparisons) {
+    template <typename T>
+    static void merge(T* arr, int l, int m, int r, long long& comparisons) {
         int n1 = m - l + 1;
         int n2 = r - m;
-        vector<int> left(n1), right(n2);
+        ScratchArena::Scope scratch;
+        T* left = ScratchArena::local().allocate<T>(n1);
+        T* right = ScratchArena::local().allocate<T>(n2);
         
         for (int i = 0; i < n1; i++) left[i] = arr[l + i];
         for (int j = 0; j < n2; j++) right[j] = arr[m + 1 + j];
@@ -93,6 +594,7 @@ public:
         int i = 0, j = 0, k = l;
         while (i < n1 && j < n2) {
             comparisons++;
+            checkCancel(comparisons);
             if (left[i] <= right[j]) {
                 arr[k++] = left[i++];
             } else {
@@ -103,9 +605,14 @@ public:
         while (j < n2) arr[k++] = right[j++];
     }
 
-    // Merge Sort Implementation
-    static void mergeSort(vector<int>& arr, int l, int r, long long& comparisons) {
+    // Merge Sort Implementation (ranges of at most leafSize() elements go to leafSort)
+    template <typename T>
+    static void mergeSort(T* arr, int l, int r, long long& comparisons) {
         if (l >= r) return;
+        if (r - l + 1 <= leafSize(T())) {
+            leafSort(arr + l, r - l + 1, comparisons);
+            return;
+        }
         int m = l + (r - l) / 2;
         mergeSort(arr, l, m, comparisons);
         mergeSort(arr, m + 1, r, comparisons);
@@ -113,15 +620,17 @@ public:
     }
 
     // Partition function for Quick Sort
-    static int partition(vector<int>& arr, int low, int high, long long& comparisons) {
+    template <typename T>
+    static int partition(T* arr, int low, int high, long long& comparisons) {
         // Randomize pivot to avoid worst-case on reversed/sorted data
-        int randomIndex = low + rand() % (high - low + 1);
+        int randomIndex = low + pivotRng().below(high - low + 1);
         swap(arr[randomIndex], arr[high]);
         
-        int pivot = arr[high];
+        T pivot = arr[high];
         int i = low - 1;
         for (int j = low; j < high; j++) {
             comparisons++;
+            checkCancel(comparisons);
             if (arr[j] < pivot) {
                 i++;
                 swap(arr[i], arr[j]);
@@ -132,276 +641,4834 @@ public:
     }
 
     // Quick Sort Implementation
-    static void quickSort(vector<int>& arr, int low, int high, long long& comparisons) {
-        if (low < high) {
+    // Recurses into the smaller side and loops on the larger one, so the stack
+    // depth stays O(log n) even when adversarial input degrades the partitions
+    // Ranges of at most leafSize() elements go to leafSort
+    template <typename T>
+    static void quickSort(T* arr, int low, int high, long long& comparisons) {
+        while (high - low + 1 > leafSize(T())) {
             int pi = partition(arr, low, high, comparisons);
-            quickSort(arr, low, pi - 1, comparisons);
-            quickSort(arr, pi + 1, high, comparisons);
+            if (pi - low < high - pi) {
+                quickSort(arr, low, pi - 1, comparisons);
+                low = pi + 1;
+            } else {
+                quickSort(arr, pi + 1, high, comparisons);
+                high = pi - 1;
+            }
         }
+        if (high > low) leafSort(arr + low, high - low + 1, comparisons);
     }
 
-    // ============= Dataset Generation Functions =============
-    
-    // Generate random dataset
-    static vector<int> generateRandomDataset(int size) {
-        vector<int> arr(size);
-        srand(time(nullptr));
-        for (int i = 0; i < size; i++) {
-            arr[i] = 1 + rand() % (size * 10);
+    // LSD radix sort: one counting pass per byte of radixBits(element), least
+    // significant first, ping-ponging through a buffer of n elements. Stable and
+    // comparison-free. Bytes below firstBit are ignored (their order is kept),
+    // and a pass is skipped when every element has the same byte there, e.g.
+    // the high bytes of small keys or of pair indices.
+    template <typename T>
+    static void radixSort(T* arr, int n, int firstBit = 0) {
+        typedef decltype(radixBits(T())) Bits;
+        if (n <= 1) return;
+        ScratchArena::Scope scratch;
+        T* from = arr;
+        T* to = ScratchArena::local().allocate<T>(n);
+        for (int shift = firstBit; shift < (int)sizeof(Bits) * 8; shift += 8) {
+            int count[256] = {};
+            for (int i = 0; i < n; i++) {
+                checkCancel(i);
+                count[(radixBits(from[i]) >> shift) & 0xFF]++;
+            }
+            if (count[(radixBits(from[0]) >> shift) & 0xFF] == n) continue;
+            
+            int offset = 0;
+            for (int b = 0; b < 256; b++) {
+                int c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for (int i = 0; i < n; i++) {
+                checkCancel(i);
+                to[count[(radixBits(from[i]) >> shift) & 0xFF]++] = from[i];
+            }
+            swap(from, to);
         }
-        return arr;
+        if (from != arr) copy(from, from + n, arr);
     }
 
-    // Generate nearly sorted dataset
-    static vector<int> generateNearlySorted(int size) {
-        vector<int> arr(size);
-        for (int i = 0; i < size; i++) arr[i] = i + 1;
+    static const int COUNTING_MAX_SPAN = 1 << 22;  // Widest key range given a count table
+
+    // Counting sort: one pass counts every key in a table indexed by
+    // key - min, a second rewrites the array from the table. O(n + span)
+    // and comparison-free; wider key ranges go to radixSort.
+    static void countingSort(int* arr, int n) {
+        if (n <= 1) return;
+        int lo = arr[0], hi = arr[0];
+        for (int i = 1; i < n; i++) {
+            lo = min(lo, arr[i]);
+            hi = max(hi, arr[i]);
+        }
+        long long span = (long long)hi - lo + 1;
+        if (span > COUNTING_MAX_SPAN) {
+            radixSort(arr, n);
+            return;
+        }
         
-        // Disorder about 10% of the elements
-        int swaps = size / 10;
-        srand(time(nullptr));
-        for (int i = 0; i < swaps; i++) {
-            int idx1 = rand() % size;
-            int idx2 = rand() % size;
-            swap(arr[idx1], arr[idx2]);
+        ScratchArena::Scope scratch;
+        int* count = ScratchArena::local().allocate<int>(span);
+        fill_n(count, span, 0);
+        for (int i = 0; i < n; i++) {
+            checkCancel(i);
+            count[arr[i] - lo]++;
+        }
+        int out = 0;
+        for (int v = 0; v < (int)span; v++) {
+            fill_n(arr + out, count[v], lo + v);
+            out += count[v];
         }
-        return arr;
     }
 
-    // Generate reversed dataset
-    static vector<int> generateReversed(int size) {
-        vector<int> arr(size);
-        for (int i = 0; i < size; i++) {
-            arr[i] = size - i;
-        }
-        return arr;
+    // Packed (key, index) pairs: a count per key would lose the index order
+    // in the low bits, so they go to radixSort
+    template <typename T>
+    static void countingSort(T* arr, int n) {
+        radixSort(arr, n);
     }
 
-    // Generate dataset with few unique values
-    static vector<int> generateFewUnique(int size, int uniqueCount) {
-        vector<int> uniqueValues;
-        srand(time(nullptr));
-        for (int i = 0; i < uniqueCount; i++) {
-            uniqueValues.push_back(rand() % 100 + 1);
-        }
-        
-        vector<int> arr(size);
-        for (int i = 0; i < size; i++) {
-            arr[i] = uniqueValues[rand() % uniqueCount];
-        }
-        return arr;
+    // ============= Sorting Networks =============
+
+    static const int SORT_NETWORK_MAX = 64;     // Largest input of the AVX2 network
+
+    // True when the CPU can run the AVX2 kernels (checked once)
+    static bool hasAvx2() {
+#if defined(SORTING_X86_SIMD)
+        static const bool supported = __builtin_cpu_supports("avx2") != 0;
+        return supported;
+#else
+        return false;
+#endif
     }
 
-    // ============= AI Analysis Module =============
-    
-    // Analyze dataset characteristics
-    static DatasetFeatures analyzeDataset(const vector<int>& data) {
-        DatasetFeatures features;
-        features.size = data.size();
-        features.data = data;
-        features.isLargeDataset = (features.size > 1000);
-        
-        if (features.size <= 1) {
-            features.sortedness = 1.0;
-            features.reversedness = 0.0;
-            features.uniqueCount = features.size;
-            features.uniqueRatio = 1.0;
-            features.type = "Single Element";
-            return features;
+    // True when the CPU can run the AVX-512 kernels (checked once)
+    static bool hasAvx512() {
+#if defined(SORTING_X86_SIMD)
+        static const bool supported = __builtin_cpu_supports("avx512f") != 0;
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    // Largest range the quick and merge sorts hand to leafSort: the whole
+    // network for ints on AVX2 machines, a short insertion sort otherwise
+    static int leafSize(int) { return hasAvx2() ? SORT_NETWORK_MAX : 16; }
+    static int leafSize(uint64_t) { return 16; }
+
+    // Base case of the quick and merge sorts and the tiny-batch engine
+    static void leafSort(int* arr, int n, long long& comparisons) {
+#if defined(SORTING_X86_SIMD)
+        if (n > 1 && n <= SORT_NETWORK_MAX && hasAvx2()) {
+            sortNetworkAvx2(arr, n, comparisons);
+            return;
         }
-        
-        // Calculate sortedness and reversedness
-        long long ascendingPairs = 0, descendingPairs = 0;
-        for (int i = 0; i < features.size - 1; i++) {
-            if (data[i] <= data[i+1]) ascendingPairs++;
-            if (data[i] >= data[i+1]) descendingPairs++;
+#endif
+        insertionSort(arr, n, comparisons);
+    }
+
+    static void leafSort(uint64_t* arr, int n, long long& comparisons) {
+        insertionSort(arr, n, comparisons);
+    }
+
+    // Sort `count` small arrays stored back to back in data (lengths[i]
+    // elements each), e.g. millions of 16-64 element groups
+    static void sortTinyBatch(int* data, const int* lengths, int count, long long& comparisons) {
+        for (int i = 0; i < count; i++) {
+            if (lengths[i] <= SORT_NETWORK_MAX) leafSort(data, lengths[i], comparisons);
+            else blockQuickSort(data, 0, lengths[i] - 1, comparisons);
+            data += lengths[i];
         }
-        
-        features.sortedness = (double)ascendingPairs / (features.size - 1);
-        features.reversedness = (double)descendingPairs / (features.size - 1);
-        
-        // Calculate uniqueness (use full dataset for accuracy)
-        unordered_set<int> uniqueElements(data.begin(), data.end());
-        
-        features.uniqueCount = uniqueElements.size();
-        features.uniqueRatio = (double)uniqueElements.size() / features.size;
-        
-        // Classify dataset type
-        if (features.sortedness >= 0.80) features.type = "Nearly Sorted";
-        else if (features.reversedness >= 0.90) features.type = "Reversed";
-        else if (features.uniqueRatio < 0.40) features.type = "Few Unique";
-        else if (features.isLargeDataset) features.type = "Large Random";
-        else features.type = "Random";
-        
-        return features;
     }
 
-    // Predict best sorting algorithm based on dataset features
-    static AlgoType predictBestAlgorithm(const DatasetFeatures& features) {
-        // AI Decision Tree based on algorithm complexity theory
-        
-        // Rule 1: Very small datasets (Size <= 50)
-        // Insertion Sort has low constant factor, faster than Quick/Merge recursion overhead
-        if (features.size <= 50) {
-            return INSERTION_SORT;
+#if defined(SORTING_X86_SIMD)
+    // One network stage inside a register: every lane meets the lane
+    // `Distance` away, and the lanes set in MaxLanes keep the larger value
+    template <int Distance, int MaxLanes>
+    SORTING_AVX2 static __m256i laneExchange(__m256i v) {
+        __m256i partner = (Distance == 1) ? _mm256_shuffle_epi32(v, 0xB1)
+                        : (Distance == 2) ? _mm256_shuffle_epi32(v, 0x4E)
+                        : _mm256_permute4x64_epi64(v, 0x4E);
+        return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), MaxLanes);
+    }
+
+    // Sort a bitonic register (three half-cleaner stages)
+    SORTING_AVX2 static __m256i mergeLanes(__m256i v) {
+        v = laneExchange<4, 0xF0>(v);
+        v = laneExchange<2, 0xCC>(v);
+        return laneExchange<1, 0xAA>(v);
+    }
+
+    // Sort the 8 lanes of a register (bitonic network, 6 stages)
+    SORTING_AVX2 static __m256i sortLanes(__m256i v) {
+        v = laneExchange<1, 0x66>(v);
+        v = laneExchange<2, 0x3C>(v);
+        v = laneExchange<1, 0x5A>(v);
+        return mergeLanes(v);
+    }
+
+    // Bitonic merge of the sorted runs v[0..s) and v[s..2s) (s registers each,
+    // s a power of two) into one sorted run of 2s registers
+    SORTING_AVX2 static void mergeRegisters(__m256i* v, int s, long long& comparisons) {
+        const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+        __m256i b[SORT_NETWORK_MAX / 16];
+        for (int t = 0; t < s; t++) b[t] = _mm256_permutevar8x32_epi32(v[2 * s - 1 - t], reverse);
+        for (int t = 0; t < s; t++) {
+            __m256i a = v[t];
+            v[t] = _mm256_min_epi32(a, b[t]);
+            v[s + t] = _mm256_max_epi32(a, b[t]);
         }
-        
-        // Rule 2: Large datasets (Size > 1000)
-        if (features.isLargeDataset) {
-            // Few unique values: Merge Sort is more stable than Quick Sort
-            if (features.uniqueRatio < 0.40) {
-                return MERGE_SORT;
+        // Both halves are now bitonic; clean across registers, then inside them
+        for (int d = s / 2; d >= 1; d /= 2) {
+            for (int t = 0; t < 2 * s; t++) {
+                if (t & d) continue;
+                __m256i lo = v[t];
+                v[t] = _mm256_min_epi32(lo, v[t + d]);
+                v[t + d] = _mm256_max_epi32(lo, v[t + d]);
             }
-            return QUICK_SORT;
+            comparisons += 8 * s;
         }
+        for (int t = 0; t < 2 * s; t++) v[t] = mergeLanes(v[t]);
+        comparisons += 8 * s + 2 * s * 12;
+    }
+
+    // Sort up to SORT_NETWORK_MAX ints: pad to 8, 16, 32 or 64 with INT_MAX,
+    // sort each register, then merge registers pairwise. The sequence of
+    // operations depends only on n, so there is nothing to mispredict.
+    SORTING_AVX2 static void sortNetworkAvx2(int* arr, int n, long long& comparisons) {
+        alignas(32) int padded[SORT_NETWORK_MAX];
+        int registers = 1;
+        while (registers * 8 < n) registers *= 2;
+        for (int i = 0; i < registers * 8; i++) padded[i] = (i < n) ? arr[i] : INT_MAX;
         
-        // Rule 3: Medium-sized datasets (50 < Size <= 1000)
-        
-        // Case A: Nearly sorted
-        // Insertion Sort degrades to O(N) for nearly sorted data
-        if (features.sortedness >= 0.80) {
-            return INSERTION_SORT;
+        __m256i v[SORT_NETWORK_MAX / 8];
+        for (int r = 0; r < registers; r++) {
+            v[r] = sortLanes(_mm256_load_si256((const __m256i*)(padded + 8 * r)));
         }
-        
-        // Case B: Reversed
-        // Merge Sort is better for reversed data (stable O(N log N))
-        // Quick Sort with fixed pivot has O(N^2) worst case on reversed data
-        if (features.reversedness >= 0.90) {
-            return MERGE_SORT;
+        comparisons += 24 * registers;
+        for (int s = 1; s < registers; s *= 2) {
+            for (int g = 0; g < registers; g += 2 * s) mergeRegisters(v + g, s, comparisons);
         }
-        
-        // Case C: Few unique values
-        if (features.uniqueRatio < 0.40) {
-            return MERGE_SORT;
+        for (int r = 0; r < registers; r++) _mm256_store_si256((__m256i*)(padded + 8 * r), v[r]);
+        memcpy(arr, padded, n * sizeof(int));
+    }
+#endif
+
+    // ============= Cache-Blocked Merge Sort =============
+
+    // Data cache sizes of the first core, read once. Linux reads sysfs and
+    // Windows asks GetLogicalProcessorInformation; levels that cannot be read
+    // keep a typical size (32 KB / 256 KB / 8 MB).
+    static const CacheSizes& cacheSizes() {
+        static const CacheSizes sizes = detectCacheSizes();
+        return sizes;
+    }
+
+    static CacheSizes detectCacheSizes() {
+        CacheSizes sizes = {32 << 10, 256 << 10, 8 << 20};
+#if defined(__linux__)
+        for (int index = 0; index < 16; index++) {
+            string dir = "/sys/devices/system/cpu/cpu0/cache/index" + to_string(index) + "/";
+            FILE* file = fopen((dir + "level").c_str(), "r");
+            if (!file) break;
+            int level = 0;
+            if (fscanf(file, "%d", &level) != 1) level = 0;
+            fclose(file);
+            
+            char type[32] = "";
+            file = fopen((dir + "type").c_str(), "r");
+            if (file) {
+                if (fscanf(file, "%31s", type) != 1) type[0] = '\0';
+                fclose(file);
+            }
+            if (strcmp(type, "Instruction") == 0) continue;
+            
+            // "48K", "2048K" or "32M"
+            unsigned long long size = 0;
+            char unit = 'K';
+            file = fopen((dir + "size").c_str(), "r");
+            if (file) {
+                if (fscanf(file, "%llu%c", &size, &unit) < 1) size = 0;
+                fclose(file);
+            }
+            size *= (unit == 'M') ? (1ULL << 20) : (unit == 'K') ? (1ULL << 10) : 1;
+            if (size == 0) continue;
+            if (level == 1) sizes.l1 = size;
+            else if (level == 2) sizes.l2 = size;
+            else if (level == 3) sizes.l3 = size;
         }
-        
-        // Case D: Random data
-        return QUICK_SORT;
+#elif defined(_WIN32)
+        DWORD bytes = 0;
+        GetLogicalProcessorInformation(nullptr, &bytes);
+        vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if (!info.empty() && GetLogicalProcessorInformation(info.data(), &bytes)) {
+            for (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry : info) {
+                if (entry.Relationship != RelationCache || entry.Cache.Type == CacheInstruction) continue;
+                if (entry.Cache.Level == 1) sizes.l1 = entry.Cache.Size;
+                else if (entry.Cache.Level == 2) sizes.l2 = entry.Cache.Size;
+                else if (entry.Cache.Level == 3) sizes.l3 = entry.Cache.Size;
+            }
+        }
+#endif
+        if (sizes.l2 < sizes.l1) sizes.l2 = sizes.l1;
+        return sizes;
     }
 
-    // Get algorithm name from type
-    static string getAlgoName(AlgoType type) {
-        switch (type) {
-            case BUBBLE_SORT: return "Bubble Sort";
-            case INSERTION_SORT: return "Insertion Sort";
-            case MERGE_SORT: return "Merge Sort";
-            case QUICK_SORT: return "Quick Sort";
-            default: return "Unknown";
+    static const int BLOCKED_FAN_IN = 256;      // Tiles merged per loser-tree pass
+
+    // Key with the element's order for the loser tree (pairs fit below EXHAUSTED
+    // because their index half is below 2^31)
+    static long long mergeKey(int value) { return value; }
+    static long long mergeKey(uint64_t pair) { return (long long)(pair ^ 0x8000000000000000ULL); }
+
+    // Bottom-up merge of arr[0..n), already sorted in runs of `width`, until
+    // the runs are `target` long. Ping-pongs with buffer; the result ends in arr.
+    template <typename T>
+    static void mergeUpTo(T* arr, T* buffer, int n, int width, int target, long long& comparisons) {
+        T* from = arr;
+        T* to = buffer;
+        for (; width < target && width < n; width *= 2) {
+            for (int lo = 0; lo < n; lo += 2 * width) {
+                int mid = min(lo + width, n);
+                int hi = min(lo + 2 * width, n);
+                mergeBranchless(from, to, lo, mid, hi, comparisons);
+            }
+            swap(from, to);
         }
+        if (from != arr) copy(from, from + n, arr);
     }
 
-    // Run sorting algorithm and measure performance
-    static SortMetrics runSort(AlgoType type, vector<int> data) {
-        SortMetrics metrics;
-        metrics.algoName = getAlgoName(type);
-        metrics.comparisons = 0;
-        
-        auto start = chrono::high_resolution_clock::now();
+    // Tiled merge sort. Runs of leafSize() are sorted by leafSort and merged up
+    // to half the L1 cache, those blocks are merged up to half the L2 cache
+    // (data plus buffer stay resident at each level), and the L2 tiles are
+    // combined by loser-tree merges of up to BLOCKED_FAN_IN tiles per pass, so
+    // data that outgrows the caches is streamed once per pass instead of once
+    // per binary level.
+    template <typename T>
+    static void blockedMergeSort(T* arr, int n, long long& comparisons) {
+        if (n <= 1) return;
+        const CacheSizes& cache = cacheSizes();
+        int run = leafSize(T());
+        int l1Block = max(run, (int)min<size_t>(cache.l1 / (2 * sizeof(T)), INT_MAX / 2));
+        int l2Tile = max(l1Block, (int)min<size_t>(cache.l2 / (2 * sizeof(T)), INT_MAX / 2));
+        ScratchArena& arena = ScratchArena::local();
+        ScratchArena::Scope scratch;
+        T* buffer = arena.allocate<T>(n);
         
-        switch (type) {
-            case BUBBLE_SORT: bubbleSort(data, metrics.comparisons); break;
-            case INSERTION_SORT: insertionSort(data, metrics.comparisons); break;
-            case MERGE_SORT: mergeSort(data, 0, data.size() - 1, metrics.comparisons); break;
-            case QUICK_SORT: quickSort(data, 0, data.size() - 1, metrics.comparisons); break;
+        for (int tile = 0; tile < n; tile += l2Tile) {
+            int tileEnd = min(n, tile + l2Tile);
+            for (int block = tile; block < tileEnd; block += l1Block) {
+                int blockEnd = min(tileEnd, block + l1Block);
+                for (int start = block; start < blockEnd; start += run) {
+                    leafSort(arr + start, min(run, blockEnd - start), comparisons);
+                }
+                mergeUpTo(arr + block, buffer + block, blockEnd - block, run, l1Block, comparisons);
+            }
+            mergeUpTo(arr + tile, buffer + tile, tileEnd - tile, l1Block, l2Tile, comparisons);
         }
         
-        auto end = chrono::high_resolution_clock::now();
-        chrono::duration<double, milli> duration = end - start;
-        metrics.executionTimeMs = duration.count();
-        
-        return metrics;
+        // Loser-tree passes over the tiles, each pass multiplying the run length by the fan-in
+        T* from = arr;
+        T* to = buffer;
+        for (long long width = l2Tile; width < n; width *= BLOCKED_FAN_IN) {
+            for (long long lo = 0; lo < n; lo += width * BLOCKED_FAN_IN) {
+                int hi = (int)min<long long>(n, lo + width * BLOCKED_FAN_IN);
+                int sources = (int)((hi - lo + width - 1) / width);
+                ScratchArena::Scope group;
+                int* pos = arena.allocate<int>(sources);
+                int* end = arena.allocate<int>(sources);
+                long long* keys = arena.allocate<long long>(sources);
+                for (int source = 0; source < sources; source++) {
+                    long long start = lo + source * width;
+                    pos[source] = (int)start;
+                    end[source] = (int)min<long long>(hi, start + width);
+                    keys[source] = mergeKey(from[start]);
+                }
+                int depth = 0;
+                while ((1 << depth) < sources) depth++;
+                
+                LoserTree tree(keys, sources);
+                for (int out = (int)lo; out < hi; out++) {
+                    int source = tree.winner();
+                    to[out] = from[pos[source]++];
+                    comparisons += depth;
+                    checkCancel(out);
+                    tree.replaceWinner(pos[source] < end[source] ? mergeKey(from[pos[source]]) : LoserTree::EXHAUSTED);
+                }
+            }
+            swap(from, to);
+        }
+        if (from != arr) copy(from, from + n, arr);
     }
-};
 
-// ============= Main Program =============
+    // ============= Branchless Kernels =============
 
-void printSeparator(char c = '=', int length = 70) {
-    cout << string(length, c) << endl;
-}
+    static const int PARTITION_BLOCK = 128;     // Elements classified per offset buffer
 
-void displayMenu() {
+    // BlockQuicksort partition of arr[lo..hi] around the pivot stored in arr[hi].
+    // A block of each side is classified first, writing the offsets of misplaced
+    // elements into a small buffer with an unconditional store and a counter
+    // bumped by the comparison result; the swaps then walk both buffers. The
+    // comparisons no longer decide a branch, so random data stops costing a
+    // misprediction on every other element. The last 2 * PARTITION_BLOCK
+    // elements are finished with a scalar scan.
+    // equalLeft sends elements equal to the pivot to the left side (used when
+    // the pivot equals the element before the range, i.e. runs of duplicates).
+    // Returns the pivot's final position.
+    template <typename T>
+    static int blockPartition(T* arr, int lo, int hi, bool equalLeft, long long& comparisons) {
+        const T pivot = arr[hi];
+        unsigned char offsetsL[PARTITION_BLOCK];
+        unsigned char offsetsR[PARTITION_BLOCK];
+        int startL = 0, numL = 0, startR = 0, numR = 0;
+        int l = lo, r = hi - 1;
+        
+        while (r - l + 1 > 2 * PARTITION_BLOCK) {
+            checkCancel(0);
+            if (numL == 0) {
+                startL = 0;
+                for (int i = 0; i < PARTITION_BLOCK; i++) {
+                    offsetsL[numL] = (unsigned char)i;
+                    numL += equalLeft ? (pivot < arr[l + i]) : !(arr[l + i] < pivot);
+                }
+                comparisons += PARTITION_BLOCK;
+            }
+            if (numR == 0) {
+                startR = 0;
+                for (int i = 0; i < PARTITION_BLOCK; i++) {
+                    offsetsR[numR] = (unsigned char)i;
+                    numR += equalLeft ? !(pivot < arr[r - i]) : (arr[r - i] < pivot);
+                }
+                comparisons += PARTITION_BLOCK;
+            }
+            int num = min(numL, numR);
+            for (int j = 0; j < num; j++) {
+                swap(arr[l + offsetsL[startL + j]], arr[r - offsetsR[startR + j]]);
+            }
+            numL -= num;
+            numR -= num;
+            startL += num;
+            startR += num;
+            if (numL == 0) l += PARTITION_BLOCK;
+            if (numR == 0) r -= PARTITION_BLOCK;
+        }
+        
+        // Everything left of l belongs left and everything right of r belongs
+        // right; the at most 2 * PARTITION_BLOCK elements between are scanned
+        for (int j = l; j <= r; j++) {
+            comparisons++;
+            bool left = equalLeft ? !(pivot < arr[j]) : (arr[j] < pivot);
+            if (left) swap(arr[l++], arr[j]);
+        }
+        swap(arr[l], arr[hi]);
+        return l;
+    }
+
+    // Quick sort over blockPartition with a random pivot. Like pdqsort, a range
+    // whose pivot equals the element just before it (a lower bound for the
+    // whole range) puts the equal keys on the left and drops them, so runs of
+    // duplicates cost one linear pass.
+    template <typename T>
+    static void blockQuickSort(T* arr, int lo, int hi, long long& comparisons) {
+        while (hi - lo + 1 > leafSize(T())) {
+            int randomIndex = lo + pivotRng().below(hi - lo + 1);
+            swap(arr[randomIndex], arr[hi]);
+            
+            comparisons++;
+            if (lo > 0 && !(arr[lo - 1] < arr[hi])) {
+                lo = blockPartition(arr, lo, hi, true, comparisons) + 1;
+                continue;
+            }
+            
+            int p = blockPartition(arr, lo, hi, false, comparisons);
+            if (p - lo < hi - p) {
+                blockQuickSort(arr, lo, p - 1, comparisons);
+                lo = p + 1;
+            } else {
+                blockQuickSort(arr, p + 1, hi, comparisons);
+                hi = p - 1;
+            }
+        }
+        if (hi > lo) leafSort(arr + lo, hi - lo + 1, comparisons);
+    }
+
+    // Merge src[lo..mid) and src[mid..hi) into dst[lo..hi). The smaller head is
+    // picked with a select and both cursors advance by the comparison result,
+    // which compilers turn into conditional moves instead of a branch.
+    template <typename T>
+    static void mergeBranchless(const T* src, T* dst, int lo, int mid, int hi, long long& comparisons) {
+        int i = lo, j = mid, k = lo;
+        while (i < mid && j < hi) {
+            comparisons++;
+            checkCancel(comparisons);
+            bool takeRight = src[j] < src[i];
+            dst[k++] = takeRight ? src[j] : src[i];
+            j += takeRight;
+            i += !takeRight;
+        }
+        while (i < mid) dst[k++] = src[i++];
+        while (j < hi) dst[k++] = src[j++];
+    }
+
+    // Bottom-up merge sort over mergeBranchless from leafSort runs,
+    // ping-ponging with one buffer
+    template <typename T>
+    static void branchlessMergeSort(T* arr, int n, long long& comparisons) {
+        if (n <= 1) return;
+        int run = leafSize(T());
+        for (int start = 0; start < n; start += run) leafSort(arr + start, min(run, n - start), comparisons);
+        ScratchArena::Scope scratch;
+        T* from = arr;
+        T* to = ScratchArena::local().allocate<T>(n);
+        for (int width = run; width < n; width *= 2) {
+            for (int lo = 0; lo < n; lo += 2 * width) {
+                int mid = min(lo + width, n);
+                int hi = min(lo + 2 * width, n);
+                mergeBranchless(from, to, lo, mid, hi, comparisons);
+            }
+            swap(from, to);
+        }
+        if (from != arr) copy(from, from + n, arr);
+    }
+
+    // Natural merge sort: the input is cut into maximal runs (non-decreasing,
+    // or strictly decreasing and then reversed, which keeps it stable), runs
+    // shorter than a leaf are extended to one with leafSort, and neighbouring
+    // runs are merged pairwise with mergeBranchless. r runs cost
+    // O(n log r): sorted or reversed input takes one pass, organ pipes two.
+    template <typename T>
+    static void runMergeSort(T* arr, int n, long long& comparisons) {
+        if (n <= 1) return;
+        int minRun = leafSize(T());
+        ScratchArena& arena = ScratchArena::local();
+        ScratchArena::Scope scratch;
+        // Every run but the last is at least minRun long
+        int* bounds = arena.allocate<int>(n / minRun + 2);
+        int count = 1;
+        bounds[0] = 0;
+        for (int start = 0; start < n;) {
+            int end = start + 1;
+            if (end < n && arr[end] < arr[start]) {
+                while (end < n && arr[end] < arr[end - 1]) {
+                    comparisons++;
+                    checkCancel(comparisons);
+                    end++;
+                }
+                reverse(arr + start, arr + end);
+            } else {
+                while (end < n && !(arr[end] < arr[end - 1])) {
+                    comparisons++;
+                    checkCancel(comparisons);
+                    end++;
+                }
+            }
+            if (end - start < minRun) {
+                end = min(n, start + minRun);
+                leafSort(arr + start, end - start, comparisons);
+            }
+            bounds[count++] = end;
+            start = end;
+        }
+        if (count <= 2) return;
+        
+        // Each pass merges pairs of runs and compacts the bounds in place
+        // (bound r/2 + 1 is written only after bounds up to r + 1 are read)
+        T* from = arr;
+        T* to = arena.allocate<T>(n);
+        while (count > 2) {
+            int merged = 1;
+            for (int r = 1; r < count; r += 2) {
+                int hi = (r + 1 < count) ? bounds[r + 1] : bounds[r];
+                mergeBranchless(from, to, bounds[r - 1], bounds[r], hi, comparisons);
+                bounds[merged++] = hi;
+            }
+            count = merged;
+            swap(from, to);
+        }
+        if (from != arr) copy(from, from + n, arr);
+    }
+
+    // ============= Vector Partition =============
+
+    // Quick sort over vectorPartition, with the same random pivots, leaf size
+    // and duplicate handling as blockQuickSort
+    template <typename T>
+    static void vectorQuickSort(T* arr, int lo, int hi, long long& comparisons) {
+        while (hi - lo + 1 > leafSize(T())) {
+            int randomIndex = lo + pivotRng().below(hi - lo + 1);
+            swap(arr[randomIndex], arr[hi]);
+            
+            comparisons++;
+            if (lo > 0 && !(arr[lo - 1] < arr[hi])) {
+                lo = vectorPartition(arr, lo, hi, true, comparisons) + 1;
+                continue;
+            }
+            
+            int p = vectorPartition(arr, lo, hi, false, comparisons);
+            if (p - lo < hi - p) {
+                vectorQuickSort(arr, lo, p - 1, comparisons);
+                lo = p + 1;
+            } else {
+                vectorQuickSort(arr, p + 1, hi, comparisons);
+                hi = p - 1;
+            }
+        }
+        if (hi > lo) leafSort(arr + lo, hi - lo + 1, comparisons);
+    }
+
+    // Partition arr[lo..hi] around the pivot in arr[hi] (same contract as
+    // blockPartition): AVX-512 or AVX2 for ints when the CPU has them, the
+    // scalar block partition otherwise
+    static int vectorPartition(int* arr, int lo, int hi, bool equalLeft, long long& comparisons) {
+#if defined(SORTING_X86_SIMD)
+        if (hi - lo >= 32 && hasAvx512()) return partitionAvx512(arr, lo, hi, equalLeft, comparisons);
+        if (hi - lo >= 16 && hasAvx2()) return partitionAvx2(arr, lo, hi, equalLeft, comparisons);
+#endif
+        return blockPartition(arr, lo, hi, equalLeft, comparisons);
+    }
+
+    static int vectorPartition(uint64_t* arr, int lo, int hi, bool equalLeft, long long& comparisons) {
+        return blockPartition(arr, lo, hi, equalLeft, comparisons);
+    }
+
+    // Lane orders for the AVX2 partition, one 4-bit lane index per slot: entry
+    // `mask` lists the lanes whose mask bit is clear (they go left) and then
+    // the lanes whose bit is set, so the right side ends up at the top
+    static const uint32_t* partitionLanes() {
+        static const vector<uint32_t> table = buildPartitionLanes();
+        return table.data();
+    }
+
+    static vector<uint32_t> buildPartitionLanes() {
+        vector<uint32_t> table(256);
+        for (int mask = 0; mask < 256; mask++) {
+            int slot = 0;
+            for (int side = 0; side < 2; side++) {
+                for (int lane = 0; lane < 8; lane++) {
+                    if (((mask >> lane) & 1) == side) table[mask] |= (uint32_t)lane << (4 * slot++);
+                }
+            }
+        }
+        return table;
+    }
+
+    // Move the remaining elements one at a time: left ones to arr[writeL++],
+    // right ones to arr[--writeR]
+    static void partitionRest(int* arr, const int* rest, int count, int pivot, bool equalLeft, int& writeL, int& writeR) {
+        for (int i = 0; i < count; i++) {
+            bool left = equalLeft ? !(pivot < rest[i]) : (rest[i] < pivot);
+            if (left) arr[writeL++] = rest[i];
+            else arr[--writeR] = rest[i];
+        }
+    }
+
+#if defined(SORTING_X86_SIMD)
+    // In-place vector partition in the style of Bramas and Blacher. The first
+    // and last vector are held in registers, which leaves one vector of free
+    // space at each end; every step reads the next vector from the end with
+    // less free space, so both ends always have room for a full store. Each
+    // vector is compared with the pivot in one instruction and its left lanes
+    // are written at writeL, its right lanes ending at writeR. The unread
+    // remainder and the two held vectors are finished by partitionRest.
+    SORTING_AVX2 static int partitionAvx2(int* arr, int lo, int hi, bool equalLeft, long long& comparisons) {
+        const int pivot = arr[hi];
+        const uint32_t* lanes = partitionLanes();
+        const __m256i pivots = _mm256_set1_epi32(pivot);
+        const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+        const __m256i ones = _mm256_set1_epi32(-1);
+        __m256i first = _mm256_loadu_si256((const __m256i*)(arr + lo));
+        __m256i last = _mm256_loadu_si256((const __m256i*)(arr + hi - 8));
+        int readL = lo + 8, readR = hi - 8, writeL = lo, writeR = hi;
+        
+        for (int step = 1; readR - readL >= 8; step++) {
+            if ((step & 63) == 0) checkCancel(0);
+            __m256i v;
+            if (readL - writeL <= writeR - readR) {
+                v = _mm256_loadu_si256((const __m256i*)(arr + readL));
+                readL += 8;
+            } else {
+                readR -= 8;
+                v = _mm256_loadu_si256((const __m256i*)(arr + readR));
+            }
+            __m256i right = equalLeft ? _mm256_cmpgt_epi32(v, pivots)
+                                      : _mm256_xor_si256(_mm256_cmpgt_epi32(pivots, v), ones);
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(right));
+            __m256i order = _mm256_srlv_epi32(_mm256_set1_epi32((int)lanes[mask]), shifts);
+            v = _mm256_permutevar8x32_epi32(v, order);
+            _mm256_storeu_si256((__m256i*)(arr + writeL), v);
+            _mm256_storeu_si256((__m256i*)(arr + writeR - 8), v);
+            int rightCount = __builtin_popcount(mask);
+            writeL += 8 - rightCount;
+            writeR -= rightCount;
+        }
+        
+        int rest[24];
+        int count = 0;
+        for (int i = readL; i < readR; i++) rest[count++] = arr[i];
+        _mm256_storeu_si256((__m256i*)(rest + count), first);
+        _mm256_storeu_si256((__m256i*)(rest + count + 8), last);
+        partitionRest(arr, rest, count + 16, pivot, equalLeft, writeL, writeR);
+        comparisons += hi - lo;
+        
+        swap(arr[writeL], arr[hi]);
+        return writeL;
+    }
+
+    // The same partition 16 lanes at a time, writing each side with an
+    // AVX-512 compress-store (only the selected lanes reach memory)
+    SORTING_AVX512 static int partitionAvx512(int* arr, int lo, int hi, bool equalLeft, long long& comparisons) {
+        const int pivot = arr[hi];
+        const __m512i pivots = _mm512_set1_epi32(pivot);
+        __m512i first = _mm512_loadu_si512(arr + lo);
+        __m512i last = _mm512_loadu_si512(arr + hi - 16);
+        int readL = lo + 16, readR = hi - 16, writeL = lo, writeR = hi;
+        
+        for (int step = 1; readR - readL >= 16; step++) {
+            if ((step & 31) == 0) checkCancel(0);
+            __m512i v;
+            if (readL - writeL <= writeR - readR) {
+                v = _mm512_loadu_si512(arr + readL);
+                readL += 16;
+            } else {
+                readR -= 16;
+                v = _mm512_loadu_si512(arr + readR);
+            }
+            __mmask16 right = equalLeft ? _mm512_cmpgt_epi32_mask(v, pivots)
+                                        : _mm512_cmpge_epi32_mask(v, pivots);
+            int rightCount = __builtin_popcount(right);
+            _mm512_mask_compressstoreu_epi32(arr + writeL, (__mmask16)~right, v);
+            _mm512_mask_compressstoreu_epi32(arr + writeR - rightCount, right, v);
+            writeL += 16 - rightCount;
+            writeR -= rightCount;
+        }
+        
+        int rest[48];
+        int count = 0;
+        for (int i = readL; i < readR; i++) rest[count++] = arr[i];
+        _mm512_storeu_si512(rest + count, first);
+        _mm512_storeu_si512(rest + count + 16, last);
+        partitionRest(arr, rest, count + 32, pivot, equalLeft, writeL, writeR);
+        comparisons += hi - lo;
+        
+        swap(arr[writeL], arr[hi]);
+        return writeL;
+    }
+#endif
+
+    // Sorted-prefix merge: arr[0..prefix-1] is already in order (prefix < 0 means
+    // detect it). Only the tail is sorted and is then merged backward into place
+    // through a buffer the size of the tail. Appending k values to a sorted
+    // array of n costs O(n + k log k).
+    // The tail's kernel follows from k alone: analysing the tail costs a fixed
+    // ~15 us, far more than sorting a short one. Short tails go through merge
+    // sort (the leaf kernel below leafSize()), long ones take the radix passes,
+    // as rule 6 picks for whole inputs.
+    template <typename T>
+    static void prefixMergeSort(T* arr, int n, int prefix, long long& comparisons) {
+        if (prefix < 0) {
+            prefix = min(n, 1);
+            while (prefix < n) {
+                comparisons++;
+                checkCancel(comparisons);
+                if (arr[prefix - 1] > arr[prefix]) break;
+                prefix++;
+            }
+        }
+        if (prefix >= n) return;
+        
+        int k = n - prefix;
+        T* tail = arr + prefix;
+        if (k > 1000) radixSort(tail, k);
+        else mergeSort(tail, 0, k - 1, comparisons);
+        if (prefix == 0) return;
+        
+        comparisons++;
+        if (arr[prefix - 1] <= tail[0]) return;     // Tail already belongs after the prefix
+        
+        // Fill from the back; on ties the tail element goes last, keeping it stable
+        ScratchArena::Scope scratch;
+        T* buffer = ScratchArena::local().allocate<T>(k);
+        copy(tail, tail + k, buffer);
+        int i = prefix - 1, j = k - 1, out = n - 1;
+        while (i >= 0 && j >= 0) {
+            comparisons++;
+            checkCancel(comparisons);
+            if (arr[i] > buffer[j]) arr[out--] = arr[i--];
+            else arr[out--] = buffer[j--];
+        }
+        while (j >= 0) arr[out--] = buffer[j--];
+    }
+
+    // ============= Partial Sort (Top-k) =============
+    // Each kernel leaves the k smallest elements in arr[0..k-1], ascending;
+    // the order of the rest is unspecified.
+
+    // Sift heap[i] down a max-heap of `size` elements
+    template <typename T>
+    static void siftDown(T* heap, int i, int size, long long& comparisons) {
+        while (true) {
+            int largest = i, l = 2 * i + 1, r = l + 1;
+            if (l < size) {
+                comparisons++;
+                if (heap[l] > heap[largest]) largest = l;
+            }
+            if (r < size) {
+                comparisons++;
+                if (heap[r] > heap[largest]) largest = r;
+            }
+            if (largest == i) return;
+            swap(heap[i], heap[largest]);
+            i = largest;
+        }
+    }
+
+    // Heap selection: a max-heap of the k smallest so far sits at the front.
+    // One sequential pass; most later elements cost a single comparison
+    // against the heap top. O(n log k), then a heap sort of the winners.
+    template <typename T>
+    static void heapSelect(T* arr, int n, int k, long long& comparisons) {
+        if (k <= 0) return;
+        for (int i = k / 2 - 1; i >= 0; i--) siftDown(arr, i, k, comparisons);
+        for (int i = k; i < n; i++) {
+            comparisons++;
+            checkCancel(comparisons);
+            if (arr[i] < arr[0]) {
+                swap(arr[i], arr[0]);
+                siftDown(arr, 0, k, comparisons);
+            }
+        }
+        for (int end = k - 1; end > 0; end--) {
+            swap(arr[0], arr[end]);
+            siftDown(arr, 0, end, comparisons);
+        }
+    }
+
+    // Introselect: quickselect on partition(), following only the side that
+    // holds position k-1 (O(n) expected). After 2*log2(n) rounds without
+    // converging it finishes the remaining range with heap selection.
+    template <typename T>
+    static void introSelect(T* arr, int n, int k, long long& comparisons) {
+        if (k <= 0) return;
+        int low = 0, high = n - 1;
+        int rounds = 2 * (int)log2((double)max(n, 2));
+        while (low < high) {
+            if (rounds-- == 0) {
+                // Sorts arr[low..k-1]; everything before low is already smaller
+                heapSelect(arr + low, high - low + 1, k - low, comparisons);
+                sortSelected(arr, low, comparisons);
+                return;
+            }
+            int pi = partition(arr, low, high, comparisons);
+            if (pi == k - 1) break;
+            if (pi < k - 1) low = pi + 1;
+            else high = pi - 1;
+        }
+        sortSelected(arr, k, comparisons);
+    }
+
+    // Radix selection: find the k-th smallest element one byte at a time, most
+    // significant first, from histograms instead of comparisons (see
+    // radixBits). Only the first pass reads the whole array; the elements in
+    // the bucket holding rank k are copied out and each later pass narrows
+    // that list. A gather pass then moves the elements below the threshold,
+    // plus enough copies of it, to the front.
+    template <typename T>
+    static void radixSelect(T* arr, int n, int k, long long& comparisons) {
+        typedef decltype(radixBits(T())) Bits;
+        if (k <= 0) return;
+        const int topShift = (int)sizeof(Bits) * 8 - 8;
+        int rank = k;       // Rank of the threshold among the elements still in play
+        ScratchArena::Scope scratch;
+        Bits* candidates = nullptr;
+        int kept = 0;
+        Bits prefix = 0;
+        for (int shift = topShift; shift >= 0; shift -= 8) {
+            int hist[256] = {};
+            if (shift == topShift) {
+                for (int i = 0; i < n; i++) {
+                    checkCancel(i);
+                    hist[(radixBits(arr[i]) >> shift) & 0xFF]++;
+                }
+            } else {
+                for (int i = 0; i < kept; i++) hist[(candidates[i] >> shift) & 0xFF]++;
+            }
+            int b = 0;
+            while (rank > hist[b]) rank -= hist[b++];
+            prefix |= (Bits)b << shift;
+            if (shift == 0) break;
+            
+            // Keep only the elements in bucket b for the next byte
+            if (shift == topShift) {
+                candidates = ScratchArena::local().allocate<Bits>(hist[b]);
+                for (int i = 0; i < n; i++) {
+                    Bits bits = radixBits(arr[i]);
+                    if (((bits >> shift) & 0xFF) == (Bits)b) candidates[kept++] = bits;
+                }
+            } else {
+                int remaining = kept;
+                kept = 0;
+                for (int i = 0; i < remaining; i++) {
+                    if (((candidates[i] >> shift) & 0xFF) == (Bits)b) candidates[kept++] = candidates[i];
+                }
+            }
+        }
+        
+        // Elements below the threshold first, then `rank` copies of it
+        int write = 0;
+        for (int i = 0; i < n; i++) {
+            comparisons++;
+            checkCancel(comparisons);
+            if (radixBits(arr[i]) < prefix) swap(arr[write++], arr[i]);
+        }
+        for (int i = write; i < n && write < k; i++) {
+            comparisons++;
+            if (radixBits(arr[i]) == prefix) swap(arr[write++], arr[i]);
+        }
+        sortSelected(arr, k, comparisons);
+    }
+
+    // Sort the selected front of the array with the kernel the selector picks for it
+    template <typename T>
+    static void sortSelected(T* arr, int k, long long& comparisons) {
+        if (k <= 1) return;
+        sortWith(predictBestAlgorithm(analyzeDataset(arr, k, 1024)), arr, k, comparisons);
+    }
+
+    // Replica of quickSort/partition over item ids, used by the antiqsort
+    // generator. Must consume the pivot generator exactly like partition does,
+    // and stops at the same leaf size (leaf ranges are never partitioned).
+    template <typename Less>
+    static void adversaryQuickSort(vector<int>& arr, int low, int high, Rng& rng, Less& less) {
+        while (high - low + 1 > leafSize(0)) {
+            int randomIndex = low + rng.below(high - low + 1);
+            swap(arr[randomIndex], arr[high]);
+            
+            int pivot = arr[high];
+            int i = low - 1;
+            for (int j = low; j < high; j++) {
+                if (less(arr[j], pivot)) {
+                    i++;
+                    swap(arr[i], arr[j]);
+                }
+            }
+            swap(arr[i + 1], arr[high]);
+            int pi = i + 1;
+            
+            if (pi - low < high - pi) {
+                adversaryQuickSort(arr, low, pi - 1, rng, less);
+                low = pi + 1;
+            } else {
+                adversaryQuickSort(arr, pi + 1, high, rng, less);
+                high = pi - 1;
+            }
+        }
+    }
+
+    // ============= Random Seeds =============
+
+    // Seed the pivot generator is reset to at the start of every runSort,
+    // so repeated runs on the same data pick the same pivots
+    static uint64_t& pivotSeed() {
+        static uint64_t seed = 0x5EED5EED5EED5EEDULL;
+        return seed;
+    }
+
+    // Per-thread pivot generator used by partition
+    static Rng& pivotRng() {
+        thread_local Rng rng;
+        return rng;
+    }
+
+    // Fresh seed for runs where the user did not fix one
+    static uint64_t randomSeed() {
+        random_device rd;
+        uint64_t x = ((uint64_t)rd() << 32) ^ rd()
+                   ^ (uint64_t)chrono::high_resolution_clock::now().time_since_epoch().count();
+        return Rng::splitMix64(x);
+    }
+
+    // ============= Dataset Generation Functions =============
+
+    static const int FILL_CHUNK = 1 << 16;   // Elements drawn from one stream
+
+    // Fill arr with gen(rng) in parallel. Chunk c always uses stream c of the
+    // seed, so the output is identical for any number of threads.
+    template <typename Generator>
+    static void parallelFill(vector<int>& arr, uint64_t seed, Generator gen) {
+        int n = arr.size();
+        int chunks = (n + FILL_CHUNK - 1) / FILL_CHUNK;
+        int threads = min(chunks, (int)max(1u, thread::hardware_concurrency()));
+        
+        auto worker = [&](int t) {
+            for (int c = t; c < chunks; c += threads) {
+                Rng rng(seed, c);
+                int end = min(n, (c + 1) * FILL_CHUNK);
+                for (int i = c * FILL_CHUNK; i < end; i++) arr[i] = gen(rng);
+            }
+        };
+        
+        if (threads <= 1) {
+            worker(0);
+            return;
+        }
+        vector<thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+        worker(0);
+        for (auto& th : pool) th.join();
+    }
+    
+    // Generate random dataset
+    static vector<int> generateRandomDataset(int size, uint64_t seed) {
+        vector<int> arr(size);
+        uint32_t range = (uint32_t)min(10LL * size, (long long)INT32_MAX - 1);
+        parallelFill(arr, seed, [range](Rng& rng) { return 1 + (int)rng.below(range); });
+        return arr;
+    }
+
+    // Generate nearly sorted dataset
+    static vector<int> generateNearlySorted(int size, uint64_t seed) {
+        vector<int> arr(size);
+        for (int i = 0; i < size; i++) arr[i] = i + 1;
+        
+        // Disorder about 10% of the elements
+        int swaps = size / 10;
+        Rng rng(seed);
+        for (int i = 0; i < swaps; i++) {
+            int idx1 = rng.below(size);
+            int idx2 = rng.below(size);
+            swap(arr[idx1], arr[idx2]);
+        }
+        return arr;
+    }
+
+    // Generate reversed dataset
+    static vector<int> generateReversed(int size) {
+        vector<int> arr(size);
+        for (int i = 0; i < size; i++) {
+            arr[i] = size - i;
+        }
+        return arr;
+    }
+
+    // Generate dataset with few unique values
+    static vector<int> generateFewUnique(int size, int uniqueCount, uint64_t seed) {
+        vector<int> uniqueValues;
+        Rng rng(seed);
+        for (int i = 0; i < uniqueCount; i++) {
+            uniqueValues.push_back(rng.below(100) + 1);
+        }
+        
+        vector<int> arr(size);
+        parallelFill(arr, rng.next(), [&uniqueValues, uniqueCount](Rng& r) {
+            return uniqueValues[r.below(uniqueCount)];
+        });
+        return arr;
+    }
+
+    // Generate organ-pipe dataset (ascending first half, descending second half)
+    static vector<int> generateOrganPipe(int size) {
+        vector<int> arr(size);
+        for (int i = 0; i < size; i++) {
+            arr[i] = (i < size / 2) ? i + 1 : size - i;
+        }
+        return arr;
+    }
+
+    // Generate sawtooth dataset made of `runs` ascending runs
+    static vector<int> generateSawtooth(int size, int runs) {
+        vector<int> arr(size);
+        int runLength = (size + runs - 1) / runs;
+        for (int i = 0; i < size; i++) {
+            arr[i] = i % runLength + 1;
+        }
+        return arr;
+    }
+
+    // Generate Zipf-distributed keys: value k appears with probability ~ 1/k^exponent
+    static vector<int> generateZipf(int size, double exponent, uint64_t seed) {
+        // Cumulative weights over a universe of at most 2^20 distinct keys
+        int universe = min(size, 1 << 20);
+        vector<double> cdf(universe);
+        double total = 0.0;
+        for (int k = 0; k < universe; k++) {
+            total += 1.0 / pow(k + 1.0, exponent);
+            cdf[k] = total;
+        }
+        
+        vector<int> arr(size);
+        parallelFill(arr, seed, [&cdf, total, universe](Rng& rng) {
+            int k = lower_bound(cdf.begin(), cdf.end(), rng.uniform() * total) - cdf.begin();
+            return min(k, universe - 1) + 1;
+        });
+        return arr;
+    }
+
+    // Generate Gaussian keys (mean 5*size, standard deviation size) via Box-Muller
+    static vector<int> generateGaussian(int size, uint64_t seed) {
+        const double TWO_PI = 6.283185307179586;
+        double mean = 5.0 * size, stddev = size;
+        vector<int> arr(size);
+        parallelFill(arr, seed, [mean, stddev, TWO_PI](Rng& rng) {
+            double r = sqrt(-2.0 * log(1.0 - rng.uniform()));
+            double value = mean + stddev * r * cos(TWO_PI * rng.uniform());
+            return (int)max(1.0, min(value, (double)INT32_MAX));
+        });
+        return arr;
+    }
+
+    // Generate sorted dataset followed by a tail of `tailLength` random values
+    static vector<int> generateSortedWithTail(int size, int tailLength, uint64_t seed) {
+        tailLength = max(0, min(tailLength, size));
+        int prefix = size - tailLength;
+        vector<int> arr(size);
+        for (int i = 0; i < prefix; i++) arr[i] = 10 * (i + 1);
+        
+        Rng rng(seed);
+        uint32_t range = (uint32_t)min(10LL * size, (long long)INT32_MAX - 1);
+        for (int i = prefix; i < size; i++) arr[i] = 1 + rng.below(range);
+        return arr;
+    }
+
+    // Generate mostly-equal dataset where about `outlierFraction` of the values are random
+    static vector<int> generateMostlyEqual(int size, double outlierFraction, uint64_t seed) {
+        int common = 5 * size;
+        uint32_t range = (uint32_t)min(10LL * size, (long long)INT32_MAX - 1);
+        vector<int> arr(size);
+        parallelFill(arr, seed, [common, range, outlierFraction](Rng& rng) {
+            return rng.uniform() < outlierFraction ? 1 + (int)rng.below(range) : common;
+        });
+        return arr;
+    }
+
+    // Generate McIlroy "antiqsort" input against quickSort as seeded by pivotSeed().
+    // Values are assigned lazily while a replica of quickSort runs: whenever two
+    // unassigned ("gas") items meet, the pivot candidate is frozen to the next
+    // smallest value, so every partition splits off a single element.
+    // Generation itself is O(size^2).
+    static vector<int> generateQuickSortKiller(int size) {
+        int gas = size;
+        vector<int> val(size, gas), items(size);
+        for (int i = 0; i < size; i++) items[i] = i;
+        
+        int nsolid = 0, candidate = 0;
+        auto less = [&](int x, int y) {
+            if (val[x] == gas && val[y] == gas) {
+                if (x == candidate) val[x] = nsolid++;
+                else val[y] = nsolid++;
+            }
+            if (val[x] == gas) candidate = x;
+            else if (val[y] == gas) candidate = y;
+            return val[x] < val[y];
+        };
+        
+        Rng rng(pivotSeed());
+        adversaryQuickSort(items, 0, size - 1, rng, less);
+        
+        vector<int> arr(size);
+        for (int i = 0; i < size; i++) arr[i] = val[i] + 1;
+        return arr;
+    }
+
+    // Generate dataset of the given type; `param` is the unique count for
+    // FEW_UNIQUE_DATA and the run count for SAWTOOTH_DATA
+    static vector<int> generateDataset(DatasetType type, int size, int param, uint64_t seed) {
+        switch (type) {
+            case RANDOM_DATA: return generateRandomDataset(size, seed);
+            case NEARLY_SORTED_DATA: return generateNearlySorted(size, seed);
+            case REVERSED_DATA: return generateReversed(size);
+            case FEW_UNIQUE_DATA: return generateFewUnique(size, param, seed);
+            case LARGE_RANDOM_DATA: return generateRandomDataset(size, seed);
+            case ORGAN_PIPE_DATA: return generateOrganPipe(size);
+            case SAWTOOTH_DATA: return generateSawtooth(size, param);
+            case ZIPF_DATA: return generateZipf(size, 1.1, seed);
+            case GAUSSIAN_DATA: return generateGaussian(size, seed);
+            case SORTED_TAIL_DATA: return generateSortedWithTail(size, size / 10, seed);
+            case QUICKSORT_KILLER_DATA: return generateQuickSortKiller(size);
+            case MOSTLY_EQUAL_DATA: return generateMostlyEqual(size, 0.01, seed);
+            default: throw invalid_argument("Unknown dataset type");
+        }
+    }
+
+    // Get dataset display name from type
+    static string getDatasetName(DatasetType type) {
+        switch (type) {
+            case RANDOM_DATA: return "Random";
+            case NEARLY_SORTED_DATA: return "Nearly Sorted";
+            case REVERSED_DATA: return "Reversed";
+            case FEW_UNIQUE_DATA: return "Few Unique";
+            case LARGE_RANDOM_DATA: return "Large Random";
+            case ORGAN_PIPE_DATA: return "Organ Pipe";
+            case SAWTOOTH_DATA: return "Sawtooth (k Sorted Runs)";
+            case ZIPF_DATA: return "Zipf Keys";
+            case GAUSSIAN_DATA: return "Gaussian Keys";
+            case SORTED_TAIL_DATA: return "Sorted + Random Tail";
+            case QUICKSORT_KILLER_DATA: return "Quick Sort Killer";
+            case MOSTLY_EQUAL_DATA: return "Mostly Equal + Outliers";
+            default: return "Unknown";
+        }
+    }
+
+    // Get command-line name (--dataset) from type
+    static string getDatasetFlag(DatasetType type) {
+        switch (type) {
+            case RANDOM_DATA: return "random";
+            case NEARLY_SORTED_DATA: return "nearly-sorted";
+            case REVERSED_DATA: return "reversed";
+            case FEW_UNIQUE_DATA: return "few-unique";
+            case LARGE_RANDOM_DATA: return "large-random";
+            case ORGAN_PIPE_DATA: return "organ-pipe";
+            case SAWTOOTH_DATA: return "sawtooth";
+            case ZIPF_DATA: return "zipf";
+            case GAUSSIAN_DATA: return "gaussian";
+            case SORTED_TAIL_DATA: return "sorted-tail";
+            case QUICKSORT_KILLER_DATA: return "qsort-killer";
+            case MOSTLY_EQUAL_DATA: return "mostly-equal";
+            default: return "unknown";
+        }
+    }
+
+    // ============= AI Analysis Module =============
+    
+    // Analyze dataset characteristics.
+    // Uniqueness is counted over all elements by default, or over a
+    // stratified random sample of `uniqueSampleLimit` of them to bound the
+    // time on huge inputs: exactly below 4096 values, above that as a
+    // HyperLogLog estimate (fixed 4 KB, about 1.6% error).
+    static DatasetFeatures analyzeDataset(const vector<int>& data, size_t uniqueSampleLimit = SIZE_MAX) {
+        return analyzeDataset(data.data(), data.size(), uniqueSampleLimit);
+    }
+
+    // Also accepts packed (key, index) pairs: the ratios, bounds and uniqueness
+    // describe the keys, while the sorted prefix is measured in element order.
+    template <typename T>
+    static DatasetFeatures analyzeDataset(const T* data, int n, size_t uniqueSampleLimit = SIZE_MAX) {
+        DatasetFeatures features;
+        features.size = n;
+        features.isLargeDataset = (features.size > 1000);
+        
+        if (features.size <= 1) {
+            features.sortedness = 1.0;
+            features.reversedness = 0.0;
+            features.uniqueCount = features.size;
+            features.uniqueRatio = 1.0;
+            features.minValue = features.maxValue = (n == 1) ? keyOf(data[0]) : 0;
+            features.sortedPrefixLength = n;
+            features.runs = features.longestRun = n;
+            features.inversionRatio = features.remRatio = features.entropyBits = 0.0;
+            features.rangeBits = 0;
+            features.type = "Single Element";
+            quantiseRatios(features);
+            return features;
+        }
+        
+        // Calculate sortedness, reversedness, bounds, the sorted prefix and the
+        // runs as runMergeSort cuts them (direction 0 = the next pair decides)
+        long long ascendingPairs = 0, descendingPairs = 0;
+        int lo = keyOf(data[0]), hi = lo;
+        int prefix = 0;
+        int runs = 1, runStart = 0, longestRun = 0, direction = 0;
+        for (int i = 0; i < features.size - 1; i++) {
+            int a = keyOf(data[i]), b = keyOf(data[i+1]);
+            if (a <= b) ascendingPairs++;
+            if (a >= b) descendingPairs++;
+            bool descent = data[i+1] < data[i];
+            if (prefix == 0 && descent) prefix = i + 1;
+            if (direction == 0) {
+                direction = descent ? -1 : 1;
+            } else if (descent != (direction < 0)) {
+                longestRun = max(longestRun, i + 1 - runStart);
+                runStart = i + 1;
+                runs++;
+                direction = 0;
+            }
+            lo = min(lo, b);
+            hi = max(hi, b);
+        }
+        
+        features.sortedness = (double)ascendingPairs / (features.size - 1);
+        features.reversedness = (double)descendingPairs / (features.size - 1);
+        features.minValue = lo;
+        features.maxValue = hi;
+        features.sortedPrefixLength = (prefix == 0) ? n : prefix;
+        features.runs = runs;
+        features.longestRun = max(longestRun, n - runStart);
+        features.rangeBits = bitWidth((uint32_t)((long long)hi - lo));
+        sampleOrderFeatures(data, n, features);
+        
+        // Calculate uniqueness. The sample takes one random element from each
+        // stretch of n/s, so neither a sorted head nor a period in the data
+        // can stand in for the rest.
+        int sampleSize = (int)min((size_t)n, uniqueSampleLimit);
+        double distinct;
+        if (sampleSize == n) {
+            distinct = HyperLogLog::countDistinct(n, [data](int i) { return keyOf(data[i]); });
+        } else {
+            Rng rng(0x5A3B1E ^ (uint64_t)n, 1);
+            distinct = HyperLogLog::countDistinct(sampleSize, [data, n, sampleSize, &rng](int t) {
+                int begin = (int)((long long)t * n / sampleSize), end = (int)((long long)(t + 1) * n / sampleSize);
+                return keyOf(data[begin + rng.below(end - begin)]);
+            });
+        }
+        
+        features.uniqueRatio = min(1.0, distinct / sampleSize);
+        features.uniqueCount = (int)(features.uniqueRatio * features.size);
+        
+        classifyDataset(features);
+        return features;
+    }
+
+    static const int FEATURE_SAMPLE = 1024;    // Pairs and elements behind the sampled features
+
+    // Number of bits in value (0 for 0)
+    static int bitWidth(uint32_t value) {
+#if defined(__GNUC__)
+        return value ? 32 - __builtin_clz(value) : 0;
+#else
+        int bits = 0;
+        while (bits < 32 && (value >> bits) != 0) bits++;
+        return bits;
+#endif
+    }
+
+    // The order and distribution features that an exact scan would make
+    // O(n log n), estimated in O(FEATURE_SAMPLE log FEATURE_SAMPLE) with a
+    // fixed seed (the same input always gets the same features):
+    //   - inversionRatio from random pairs (1/2 on random distinct keys);
+    //   - remRatio (Rem: fewest elements to remove to leave a sorted
+    //     sequence) from the longest non-decreasing subsequence of a
+    //     stratified sample, one random element per stretch of n/s, which
+    //     keeps the sample in input order without aliasing periodic inputs;
+    //   - entropyBits from the run lengths of the same sample once sorted.
+    // Osc (how often the input oscillates around each element) has no
+    // sublinear estimate and is left out.
+    // Inputs of at most FEATURE_SAMPLE elements are taken whole, so Rem and
+    // the entropy are exact there, and only n pairs are drawn: the features
+    // must stay cheap next to sorting a hundred elements.
+    template <typename T>
+    static void sampleOrderFeatures(const T* data, int n, DatasetFeatures& features) {
+        Rng rng(0x5A3B1E ^ (uint64_t)n);
+        int pairs = 0, inversions = 0;
+        for (int t = min(n, (int)FEATURE_SAMPLE); t > 0; t--) {
+            int i = rng.below(n), j = rng.below(n);
+            if (i == j) continue;
+            if (i > j) swap(i, j);
+            pairs++;
+            if (keyOf(data[i]) > keyOf(data[j])) inversions++;
+        }
+        features.inversionRatio = (pairs > 0) ? (double)inversions / pairs : 0.0;
+        
+        int s = min(n, (int)FEATURE_SAMPLE);
+        ScratchArena::Scope scratch;
+        int* sample = ScratchArena::local().allocate<int>(s);
+        int* tails = ScratchArena::local().allocate<int>(s);
+        int longest = 0;
+        if (s == n) {
+            for (int t = 0; t < n; t++) sample[t] = keyOf(data[t]);
+        } else {
+            for (int t = 0; t < s; t++) {
+                int begin = (int)((long long)t * n / s), end = (int)((long long)(t + 1) * n / s);
+                sample[t] = keyOf(data[begin + rng.below(end - begin)]);
+            }
+        }
+        for (int t = 0; t < s; t++) {
+            int* it = upper_bound(tails, tails + longest, sample[t]);
+            if (it == tails + longest) longest++;
+            *it = sample[t];
+        }
+        features.remRatio = 1.0 - (double)longest / s;
+        
+        sort(sample, sample + s);
+        double entropy = 0.0;
+        for (int i = 0, j = 0; i < s; i = j) {
+            while (j < s && sample[j] == sample[i]) j++;
+            double p = (double)(j - i) / s;
+            entropy -= p * log2(p);
+        }
+        features.entropyBits = entropy;
+    }
+
+    // Name the dataset shape from its ratios (and quantise them)
+    static void classifyDataset(DatasetFeatures& features) {
+        if (features.sortedness >= 0.80) features.type = "Nearly Sorted";
+        else if (features.reversedness >= 0.90) features.type = "Reversed";
+        else if (features.uniqueRatio < 0.40) features.type = "Few Unique";
+        else if (features.isLargeDataset) features.type = "Large Random";
+        else features.type = "Random";
+        quantiseRatios(features);
+    }
+
+    static const int RATIO_BITS = 3;    // Eighths
+
+    // Pack the three ratios as sortedness << 6 | reversedness << 3 | uniqueness,
+    // once per analysis, so table lookups need no floating point
+    static void quantiseRatios(DatasetFeatures& features) {
+        features.ratioCells = (ratioLevel(features.sortedness) << (2 * RATIO_BITS))
+                            | (ratioLevel(features.reversedness) << RATIO_BITS) | ratioLevel(features.uniqueRatio);
+    }
+
+    static int ratioLevel(double ratio) {
+        return min((1 << RATIO_BITS) - 1, max(0, (int)(ratio * (1 << RATIO_BITS))));
+    }
+
+    // Predict best sorting algorithm based on dataset features
+    static AlgoType predictBestAlgorithm(const DatasetFeatures& features) {
+        // AI Decision Tree based on algorithm complexity theory
+        
+        // Rule 1: Very small datasets (Size <= 50)
+        // Insertion Sort has low constant factor, faster than Quick/Merge recursion overhead.
+        // On AVX2 machines the sorting network is faster still, and Block Quick
+        // Sort hands inputs this small straight to it.
+        if (features.size <= 50) {
+            return hasAvx2() ? BLOCK_QUICK_SORT : INSERTION_SORT;
+        }
+        
+        // Rule 2: Already sorted or reversed (a single run)
+        // The run merge finds the run in one pass and reverses it if needed
+        if (features.runs == 1) {
+            return RUN_MERGE_SORT;
+        }
+        
+        // Rule 3: Keys from a range at most twice as wide as the input (permutations, ids, codes)
+        // Counting Sort reads the data once and writes it once, O(n + range).
+        // Large inputs with only a few bits of key entropy are left to rule 6:
+        // the vector partition drops each run of equal keys in one pass.
+        bool fewKeys = features.isLargeDataset && hasAvx2() && features.entropyBits < 4.0;
+        if ((long long)features.maxValue - features.minValue < 2LL * features.size && !fewKeys) {
+            return COUNTING_SORT;
+        }
+        
+        // Rule 4: A handful of runs (organ pipes, appended sorted batches)
+        // Merging the runs found in the input costs O(n log runs)
+        if (features.runs <= 4) {
+            return RUN_MERGE_SORT;
+        }
+        
+        // Rule 5: Sorted prefix followed by an unsorted tail (append workloads)
+        // Sorting only the tail and merging keeps the existing order: O(n + k log k).
+        // Below 64 elements the tail is a single leaf sort and the extra prefix
+        // scan and merge pass cost more than they save, so the rules below sort
+        // the whole input.
+        if (features.size >= 64 && features.sortedPrefixLength >= features.size / 2
+            && features.sortedPrefixLength < features.size) {
+            return PREFIX_MERGE;
+        }
+        
+        // Rule 6: Large datasets (Size > 1000)
+        // Four byte passes of Radix Sort beat O(N log N) scalar comparisons on
+        // every shape, and it has no pivot or duplicate-key worst case; keys
+        // within 16 bits of each other leave it two passes.
+        // The vector partition compares 16 keys per instruction with AVX-512
+        // and beats the full four passes; with AVX2 only it still wins when
+        // keys repeat (duplicate runs are dropped in one pass)
+        if (features.isLargeDataset) {
+            if (hasAvx2() && features.uniqueRatio < 0.40) {
+                return VECTOR_QUICK_SORT;
+            }
+            if (hasAvx512() && features.rangeBits > 16) {
+                return VECTOR_QUICK_SORT;
+            }
+            return RADIX_SORT;
+        }
+        
+        // Rule 7: Medium-sized datasets (50 < Size <= 1000)
+        
+        // Case A: Nearly sorted
+        // Insertion Sort costs O(N + inversions), so it only pays off when
+        // there are about as few inversions as elements (a high share of
+        // ordered neighbours alone can still hide long moves)
+        if (features.inversionRatio * features.size <= 2.0) {
+            return INSERTION_SORT;
+        }
+        
+        // Case B: Reversed, few unique values or random data
+        // Block Quick Sort: random pivots avoid the reversed-input worst case,
+        // runs of duplicates are dropped in one pass, and the block partition
+        // does not mispredict on random data. The vector partition does the
+        // same work 8 or 16 keys at a time.
+        return hasAvx2() ? VECTOR_QUICK_SORT : BLOCK_QUICK_SORT;
+    }
+
+    // Pick the top-k kernel from the dataset features and k/n
+    static AlgoType predictTopKAlgorithm(const DatasetFeatures& features, int k) {
+        // Asking for everything: a full sort is the partial sort
+        if (k >= features.size) {
+            return predictBestAlgorithm(features);
+        }
+        
+        double ratio = (double)k / features.size;
+        
+        // Descending data defeats the heap (every element displaces its top);
+        // quickselect's randomized pivots do not care about the order
+        if (features.reversedness >= 0.90) {
+            return INTRO_SELECT;
+        }
+        
+        // Small k: the heap top rejects almost every element with one comparison.
+        // Up to 10% of n this still holds when most elements arrive in order or
+        // repeat the current top.
+        if (ratio <= 0.01 || (ratio <= 0.10 && (features.sortedness >= 0.80 || features.uniqueRatio < 0.40))) {
+            return HEAP_SELECT;
+        }
+        
+        // Many duplicates stall partition(), which sends every equal key to one
+        // side; byte histograms are unaffected
+        if (features.uniqueRatio < 0.40) {
+            return RADIX_SELECT;
+        }
+        return INTRO_SELECT;
+    }
+
+    // Get algorithm name from type. The names are built once, so asking for
+    // one (every run and report does) copies nothing.
+    static const string& getAlgoName(AlgoType type) {
+        static const string names[ALGO_TYPE_COUNT + 1] = {
+            "Bubble Sort", "Insertion Sort", "Merge Sort", "Quick Sort", "Prefix Merge",
+            "Radix Sort", "Blocked Merge", "Block Quick", "Branchless Merge", "Vector Quick",
+            "Run Merge", "Counting Sort", "Heap Select", "Intro Select", "Radix Select",
+            "Unknown"
+        };
+        return names[(type >= 0 && type < ALGO_TYPE_COUNT) ? type : ALGO_TYPE_COUNT];
+    }
+
+    // Sort data[0..n-1] in place with the given algorithm. The top-k kernels
+    // only sort the k smallest into data[0..k-1] (k < 0 means all of them);
+    // the full sorts ignore k.
+    template <typename T>
+    static void sortWith(AlgoType type, T* data, int n, long long& comparisons, int k = -1) {
+        if (k < 0 || k > n) k = n;
+        switch (type) {
+            case BUBBLE_SORT: bubbleSort(data, n, comparisons); break;
+            case INSERTION_SORT: insertionSort(data, n, comparisons); break;
+            case MERGE_SORT: mergeSort(data, 0, n - 1, comparisons); break;
+            case QUICK_SORT: quickSort(data, 0, n - 1, comparisons); break;
+            case PREFIX_MERGE: prefixMergeSort(data, n, -1, comparisons); break;
+            case RADIX_SORT: radixSort(data, n); break;
+            case BLOCKED_MERGE_SORT: blockedMergeSort(data, n, comparisons); break;
+            case BLOCK_QUICK_SORT: blockQuickSort(data, 0, n - 1, comparisons); break;
+            case BRANCHLESS_MERGE_SORT: branchlessMergeSort(data, n, comparisons); break;
+            case VECTOR_QUICK_SORT: vectorQuickSort(data, 0, n - 1, comparisons); break;
+            case RUN_MERGE_SORT: runMergeSort(data, n, comparisons); break;
+            case COUNTING_SORT: countingSort(data, n); break;
+            case HEAP_SELECT: heapSelect(data, n, k, comparisons); break;
+            case INTRO_SELECT: introSelect(data, n, k, comparisons); break;
+            case RADIX_SELECT: radixSelect(data, n, k, comparisons); break;
+            default: break;
+        }
+    }
+
+    template <typename T>
+    static void sortWith(AlgoType type, vector<T>& data, long long& comparisons, int k = -1) {
+        sortWith(type, data.data(), data.size(), comparisons, k);
+    }
+
+    // Run sorting algorithm and measure performance.
+    // If `cancel` or `raceOver` is raised while running, the kernel stops within
+    // a few thousand comparisons and the metrics are returned with cancelled = true.
+    // k > 0 asks only for the k smallest elements (see sortWith).
+    // The input is copied into the thread's ScratchArena and sorted there, so
+    // a thread that has run a sort this size before makes no heap allocations.
+    // onReady, if set, is called after the copy and before the clock starts.
+    static SortMetrics runSort(AlgoType type, const vector<int>& input, const atomic<bool>* cancel = nullptr,
+                               const atomic<bool>* raceOver = nullptr, int k = -1,
+                               const function<void()>& onReady = nullptr) {
+        SortMetrics metrics;
+        metrics.algo = type;
+        metrics.comparisons = 0;
+        long long allocationsBefore = heapAllocations();
+        {
+            ScratchArena::Scope scratch;
+            int n = (int)input.size();
+            int* data = ScratchArena::local().allocate<int>(n);
+            copy(input.begin(), input.end(), data);
+            pivotRng() = Rng(pivotSeed());
+            cancelFlag() = cancel;
+            raceFlag() = raceOver;
+            if (onReady) onReady();
+            
+            metrics.startedAtMs = chrono::duration<double, milli>(
+                chrono::steady_clock::now().time_since_epoch()).count();
+            auto start = chrono::high_resolution_clock::now();
+            
+            try {
+                sortWith(type, data, n, metrics.comparisons, k);
+            } catch (const SortCancelled&) {
+                metrics.cancelled = true;
+            }
+            cancelFlag() = nullptr;
+            raceFlag() = nullptr;
+            
+            auto end = chrono::high_resolution_clock::now();
+            chrono::duration<double, milli> duration = end - start;
+            metrics.executionTimeMs = duration.count();
+        }
+        // Counted after the Scope, so growing the arena for next time is included
+        metrics.heapAllocations = heapAllocations() - allocationsBefore;
+        
+        return metrics;
+    }
+
+    // ============= Argsort and Records =============
+
+    // Stable argsort: the permutation that sorts `keys`. The kernel runs over
+    // packed 64-bit (key, index) pairs, so each move touches 8 contiguous
+    // bytes instead of a key plus a separately stored index, and equal keys
+    // keep their input order whatever the algorithm.
+    static vector<uint32_t> argsort(const int* keys, int n, AlgoType type, long long& comparisons) {
+        ScratchArena::Scope scratch;
+        uint64_t* pairs = ScratchArena::local().allocate<uint64_t>(n);
+        for (int i = 0; i < n; i++) pairs[i] = packPair(keys[i], (uint32_t)i);
+        if (type == RADIX_SORT) {
+            // The pairs start in index order, so the key bytes alone are enough
+            radixSort(pairs, n, 32);
+        } else {
+            sortWith(type, pairs, n, comparisons);
+        }
+        vector<uint32_t> order(n);
+        for (int i = 0; i < n; i++) order[i] = (uint32_t)pairs[i];
+        return order;
+    }
+
+    static const int INLINE_PAYLOAD_MIN_SIZE = 256;    // Below this the radix passes' setup dominates
+
+    // Choose how to sort records from the key features and the payload width.
+    // The usual path sorts (key, index) pairs and then gathers every payload
+    // column once, which reads the payload in random order. A payload of at
+    // most 4 bytes fits next to the key in one 64-bit word instead, so it
+    // moves with its key and needs no index or gather; that path uses a radix
+    // sort over the key bytes only, which keeps equal keys in input order.
+    static RecordPlan predictRecordPlan(const DatasetFeatures& features, size_t payloadBytes) {
+        RecordPlan plan;
+        plan.inlinePayload = payloadBytes <= 4 && features.size >= INLINE_PAYLOAD_MIN_SIZE;
+        plan.algo = plan.inlinePayload ? RADIX_SORT : predictBestAlgorithm(features);
+        return plan;
+    }
+
+    // Stable sort of the records by key, carrying every payload column along
+    static void sortRecords(RecordTable& table, const RecordPlan& plan, long long& comparisons) {
+        int n = table.size();
+        if (plan.inlinePayload && table.payloadBytes() <= 4) {
+            ScratchArena::Scope scratch;
+            uint64_t* words = ScratchArena::local().allocate<uint64_t>(n);
+            for (int i = 0; i < n; i++) {
+                uint32_t payload = 0;
+                size_t at = 0;
+                for (size_t c = 0; c < table.columns.size(); c++) {
+                    memcpy((unsigned char*)&payload + at, &table.columns[c][i * table.widths[c]], table.widths[c]);
+                    at += table.widths[c];
+                }
+                words[i] = packPair(table.keys[i], payload);
+            }
+            radixSort(words, n, 32);
+            for (int i = 0; i < n; i++) {
+                table.keys[i] = keyOf(words[i]);
+                uint32_t payload = (uint32_t)words[i];
+                size_t at = 0;
+                for (size_t c = 0; c < table.columns.size(); c++) {
+                    memcpy(&table.columns[c][i * table.widths[c]], (unsigned char*)&payload + at, table.widths[c]);
+                    at += table.widths[c];
+                }
+            }
+            return;
+        }
+        
+        vector<uint32_t> order = argsort(table.keys.data(), n, plan.algo, comparisons);
+        vector<int> keys(n);
+        for (int i = 0; i < n; i++) keys[i] = table.keys[order[i]];
+        table.keys.swap(keys);
+        for (size_t c = 0; c < table.columns.size(); c++) {
+            size_t w = table.widths[c];
+            const vector<unsigned char>& column = table.columns[c];
+            vector<unsigned char> gathered(column.size());
+            for (int i = 0; i < n; i++) memcpy(&gathered[i * w], &column[order[i] * w], w);
+            table.columns[c].swap(gathered);
+        }
+    }
+
+    // ============= Parallel Comparison =============
+
+    // Logical cores this process may run on
+    static vector<int> availableCores() {
+        vector<int> cores;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int c = 0; c < CPU_SETSIZE; c++) {
+                if (CPU_ISSET(c, &set)) cores.push_back(c);
+            }
+        }
+#elif defined(_WIN32)
+        DWORD_PTR processMask, systemMask;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+            for (int c = 0; c < (int)(8 * sizeof(DWORD_PTR)); c++) {
+                if (processMask & ((DWORD_PTR)1 << c)) cores.push_back(c);
+            }
+        }
+#endif
+        if (cores.empty()) {
+            for (int c = 0; c < (int)max(1u, thread::hardware_concurrency()); c++) cores.push_back(c);
+        }
+        return cores;
+    }
+
+    // Pin the calling thread to one logical core; returns false if unsupported
+    static bool pinThreadToCore(int core) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core) != 0;
+#else
+        (void)core;
+        return false;
+#endif
+    }
+
+    // Fill in overlapMs: for each run, the time during which at least one
+    // other run was executing (union of the pairwise interval overlaps)
+    static void computeOverlap(vector<SortMetrics>& results) {
+        for (size_t i = 0; i < results.size(); i++) {
+            double s1 = results[i].startedAtMs, e1 = s1 + results[i].executionTimeMs;
+            vector<pair<double, double> > spans;
+            for (size_t j = 0; j < results.size(); j++) {
+                if (j == i) continue;
+                double s2 = results[j].startedAtMs, e2 = s2 + results[j].executionTimeMs;
+                double from = max(s1, s2), to = min(e1, e2);
+                if (from < to) spans.push_back(make_pair(from, to));
+            }
+            sort(spans.begin(), spans.end());
+            
+            double total = 0.0, curFrom = 0.0, curTo = -1.0;
+            for (const auto& sp : spans) {
+                if (sp.first > curTo) {
+                    if (curTo > curFrom) total += curTo - curFrom;
+                    curFrom = sp.first;
+                    curTo = sp.second;
+                } else {
+                    curTo = max(curTo, sp.second);
+                }
+            }
+            if (curTo > curFrom) total += curTo - curFrom;
+            results[i].overlapMs = total;
+        }
+    }
+
+    // True when a run shared the machine with other candidates for more than
+    // 5% of its time, so memory-bandwidth contention may have inflated it
+    static bool hasInterference(const SortMetrics& m) {
+        return m.overlapMs > 0.05 * m.executionTimeMs;
+    }
+
+    // Run the algorithms concurrently, each on its own thread pinned to its own
+    // core (core 0 is left to the caller when there is more than one) and each
+    // sorting a private copy of the data. No two runs share a core: when there
+    // are more algorithms than cores they run in successive heats of one run
+    // per core. Within a heat nobody starts until every run is pinned and has
+    // its copy. onResult is called as each run finishes; calls are serialized
+    // but come from the worker threads.
+    // Results are returned in the order of `algorithms`, with overlapMs set.
+    static vector<SortMetrics> runParallelComparison(const vector<AlgoType>& algorithms, const vector<int>& data,
+                                                     const function<void(const SortMetrics&)>& onResult = nullptr,
+                                                     const atomic<bool>* cancel = nullptr, int k = -1) {
+        return runConcurrently(algorithms, data, onResult, cancel, false, k);
+    }
+
+    // Same as runParallelComparison, but the first algorithm to finish wins
+    // and the others are stopped cooperatively. Losers come back with
+    // cancelled = true and the time they ran before being stopped, so
+    // O(n^2) algorithms can take part at any size. Later heats are stopped
+    // once they run longer than the fastest finish so far, and the O(n^2)
+    // sorts go in the last heats so they always meet such a limit.
+    static vector<SortMetrics> runRace(const vector<AlgoType>& algorithms, const vector<int>& data,
+                                       const function<void(const SortMetrics&)>& onResult = nullptr,
+                                       const atomic<bool>* cancel = nullptr, int k = -1) {
+        return runConcurrently(algorithms, data, onResult, cancel, true, k);
+    }
+
+private:
+    static vector<SortMetrics> runConcurrently(const vector<AlgoType>& algorithms, const vector<int>& data,
+                                               const function<void(const SortMetrics&)>& onResult,
+                                               const atomic<bool>* cancel, bool race, int k) {
+        vector<int> cores = availableCores();
+        if (cores.size() > 1) cores.erase(cores.begin());
+        
+        // Run order: a race puts the O(n^2) sorts last
+        vector<size_t> order(algorithms.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        if (race) {
+            stable_partition(order.begin(), order.end(), [&algorithms](size_t i) {
+                return algorithms[i] != BUBBLE_SORT && algorithms[i] != INSERTION_SORT;
+            });
+        }
+        
+        vector<SortMetrics> results(algorithms.size());
+        mutex reportLock;
+        double bestMs = -1.0;   // Fastest finish so far: the time limit for later heats of a race
+        for (size_t first = 0; first < order.size(); first += cores.size()) {
+            size_t heat = min(cores.size(), order.size() - first);
+            atomic<bool> raceOver(false);
+            atomic<bool> go(false);
+            mutex stateLock;
+            condition_variable changed;
+            size_t ready = 0, finished = 0;
+            
+            vector<thread> pool;
+            for (size_t j = 0; j < heat; j++) {
+                size_t i = order[first + j];
+                pool.emplace_back([&, i, j]() {
+                    int core = cores[j];
+                    bool pinned = pinThreadToCore(core);
+                    // Start barrier: wait until the whole heat is pinned and has its copy
+                    auto waitForGo = [&]() {
+                        {
+                            lock_guard<mutex> guard(stateLock);
+                            ready++;
+                        }
+                        changed.notify_all();
+                        while (!go.load(memory_order_acquire)) this_thread::yield();
+                    };
+                    SortMetrics m = runSort(algorithms[i], data, cancel, race ? &raceOver : nullptr, k, waitForGo);
+                    m.core = pinned ? core : -1;
+                    if (race && !m.cancelled) raceOver.store(true);
+                    {
+                        lock_guard<mutex> guard(reportLock);
+                        results[i] = m;
+                        if (onResult) onResult(m);
+                    }
+                    {
+                        lock_guard<mutex> guard(stateLock);
+                        finished++;
+                    }
+                    changed.notify_all();
+                });
+            }
+            {
+                unique_lock<mutex> lock(stateLock);
+                changed.wait(lock, [&]() { return ready == heat; });
+            }
+            go.store(true, memory_order_release);
+            if (race && bestMs >= 0) {
+                unique_lock<mutex> lock(stateLock);
+                if (!changed.wait_for(lock, chrono::duration<double, milli>(bestMs), [&]() { return finished == heat; })) {
+                    raceOver.store(true);
+                }
+            }
+            for (auto& th : pool) th.join();
+            
+            for (size_t j = 0; j < heat; j++) {
+                const SortMetrics& m = results[order[first + j]];
+                if (!m.cancelled && (bestMs < 0 || m.executionTimeMs < bestMs)) bestMs = m.executionTimeMs;
+            }
+        }
+        
+        computeOverlap(results);
+        return results;
+    }
+};
+
+// ============= Incremental Feature Tracking =============
+
+// Keeps DatasetFeatures current for a buffer that is appended to or patched
+// between sorts, so the selector does not rescan the whole array each time.
+// Every push_back() and set() costs O(1):
+//   - ascending/descending adjacent pair counts are adjusted for the (at most
+//     two) pairs touching the changed slot;
+//   - min/max widen on every write; overwriting the current min or max leaves
+//     them as loose (still valid) bounds until the next rebuild();
+//   - cardinality comes from a HyperLogLog sketch, which only grows, so
+//     overwritten values keep counting until the next rebuild();
+//   - the sorted prefix grows on in-order appends and shrinks when a write
+//     breaks it, but is never re-extended by a write (it may under-report).
+// rebuild() rescans in O(n) and restores exact values; markSorted() does the
+// same in O(1) right after the buffer has been sorted.
+class FeatureTracker {
+public:
+    FeatureTracker() : ascendingPairs(0), descendingPairs(0), lo(INT_MAX), hi(INT_MIN), prefix(0) {}
+
+    explicit FeatureTracker(vector<int> initial) : FeatureTracker() {
+        values.swap(initial);
+        rebuild();
+    }
+
+    const vector<int>& data() const { return values; }
+    vector<int>& mutableData() { return values; }      // Call rebuild() after changing it
+    int size() const { return (int)values.size(); }
+    int sortedPrefixLength() const { return prefix; }
+
+    void push_back(int value) {
+        int n = (int)values.size();
+        if (n > 0) {
+            int last = values[n - 1];
+            if (last <= value) ascendingPairs++;
+            if (last >= value) descendingPairs++;
+            if (prefix == n && last <= value) prefix++;
+        } else {
+            prefix = 1;
+        }
+        values.push_back(value);
+        widen(value);
+        sketch.add(value);
+    }
+
+    void set(int index, int value) {
+        int n = (int)values.size();
+        if (index > 0) countPair(values[index - 1], values[index], -1);
+        if (index + 1 < n) countPair(values[index], values[index + 1], -1);
+        values[index] = value;
+        if (index > 0) countPair(values[index - 1], value, +1);
+        if (index + 1 < n) countPair(value, values[index + 1], +1);
+        
+        if (index < prefix) {
+            if (index > 0 && values[index - 1] > value) prefix = index;
+            else if (index + 1 < prefix && value > values[index + 1]) prefix = index + 1;
+        }
+        widen(value);
+        sketch.add(value);
+    }
+
+    // Rescan the buffer and reset every feature to its exact value
+    void rebuild() {
+        ascendingPairs = descendingPairs = 0;
+        lo = INT_MAX;
+        hi = INT_MIN;
+        sketch.clear();
+        int n = (int)values.size();
+        prefix = n;
+        for (int i = 0; i < n; i++) {
+            if (i + 1 < n) {
+                if (values[i] <= values[i + 1]) ascendingPairs++;
+                else if (prefix == n) prefix = i + 1;
+                if (values[i] >= values[i + 1]) descendingPairs++;
+            }
+            widen(values[i]);
+            sketch.add(values[i]);
+        }
+    }
+
+    // Record that the buffer was just sorted. Sorting keeps the multiset, so the
+    // sketch stays valid; in sorted order the only descending pairs are equal
+    // neighbours, of which there are n - distinct.
+    void markSorted() {
+        int n = (int)values.size();
+        prefix = n;
+        if (n == 0) return;
+        lo = values[0];
+        hi = values[n - 1];
+        ascendingPairs = n - 1;
+        descendingPairs = max(0LL, (long long)n - (long long)(sketch.estimate() + 0.5));
+    }
+
+    // Same fields as SortingEngine::analyzeDataset, in O(1) plus the sketch's
+    // fixed 4096-register scan. The order features that need a scan are
+    // bounded from the pair counts: runs counts non-decreasing runs only
+    // (one per descent, so reversed data shows as many runs), the prefix
+    // stands in for the longest run, adjacent descents for inversions and
+    // Rem, and the entropy assumes every distinct key is equally common.
+    DatasetFeatures features() const {
+        DatasetFeatures f;
+        int n = (int)values.size();
+        f.size = n;
+        f.isLargeDataset = (n > 1000);
+        f.minValue = n > 0 ? lo : 0;
+        f.maxValue = n > 0 ? hi : 0;
+        f.sortedPrefixLength = prefix;
+        f.rangeBits = n > 0 ? SortingEngine::bitWidth((uint32_t)((long long)hi - lo)) : 0;
+        if (n <= 1) {
+            f.sortedness = 1.0;
+            f.reversedness = 0.0;
+            f.uniqueCount = n;
+            f.uniqueRatio = 1.0;
+            f.runs = f.longestRun = n;
+            f.inversionRatio = f.remRatio = f.entropyBits = 0.0;
+            f.type = "Single Element";
+            SortingEngine::quantiseRatios(f);
+            return f;
+        }
+        f.sortedness = (double)ascendingPairs / (n - 1);
+        f.reversedness = (double)descendingPairs / (n - 1);
+        f.uniqueRatio = min(1.0, sketch.estimate() / n);
+        f.uniqueCount = (int)(f.uniqueRatio * n);
+        f.runs = (int)(n - ascendingPairs);
+        f.longestRun = prefix;
+        f.inversionRatio = f.remRatio = 1.0 - f.sortedness;
+        f.entropyBits = log2(max(1.0, sketch.estimate()));
+        SortingEngine::classifyDataset(f);
+        return f;
+    }
+
+private:
+    vector<int> values;
+    long long ascendingPairs;
+    long long descendingPairs;
+    int lo, hi;
+    int prefix;
+    HyperLogLog sketch;
+
+    void countPair(int left, int right, int delta) {
+        if (left <= right) ascendingPairs += delta;
+        if (left >= right) descendingPairs += delta;
+    }
+
+    void widen(int value) {
+        lo = min(lo, value);
+        hi = max(hi, value);
+    }
+};
+
+// ============= Algorithm Selection =============
+
+// A strategy that picks a sorting engine from dataset features. Every
+// strategy reads the same DatasetFeatures, so they can be swapped behind
+// one pointer or compared on the same inputs (--selector, --regret-grid).
+class Selector {
+public:
+    virtual ~Selector() {}
+    virtual string name() const = 0;
+    virtual AlgoType predict(const DatasetFeatures& features) const = 0;
+    
+    // Pick for this exact input; strategies that look at the data itself
+    // override it and report the time they spent in *overheadMs
+    virtual AlgoType predictOn(const vector<int>& data, const DatasetFeatures& features,
+                               double* overheadMs = nullptr) const {
+        (void)data;
+        if (overheadMs) *overheadMs = 0;
+        return predict(features);
+    }
+};
+
+// The hand-written decision tree (SortingEngine::predictBestAlgorithm)
+class RuleSelector : public Selector {
+public:
+    string name() const { return "rules"; }
+    AlgoType predict(const DatasetFeatures& features) const { return SortingEngine::predictBestAlgorithm(features); }
+};
+
+// Weighted k-nearest-neighbour vote over labelled feature points, as in the
+// AI module's KNN optimizer. Size is compared on a log scale (the inputs
+// span 10 to 10^7 elements), and the labels are the fastest engine measured
+// for each shape and size by the regret grid.
+class KnnSelector : public Selector {
+public:
+    struct Sample {
+        int size;
+        double sortedness;
+        double reversedness;
+        double uniqueRatio;
+        AlgoType best;
+    };
+
+    // The labelled points are shared with the AI module's KNNOptimizer, which
+    // reads the classic-algorithm column; this selector reads the engine column
+    explicit KnnSelector(int k = 5) : k(k) {
+#define KNN_SAMPLE(size, sorted, reversed, unique, classic, engine) \
+        samples.push_back({size, sorted, reversed, unique, engine});
+#include "../AI_Module/KNN_TrainingSet.h"
+#undef KNN_SAMPLE
+    }
+
+    string name() const { return "knn"; }
+
+    AlgoType predict(const DatasetFeatures& features) const {
+        ScratchArena::Scope scratch;
+        int count = (int)samples.size();
+        pair<double, AlgoType>* neighbours = ScratchArena::local().allocate<pair<double, AlgoType> >(count);
+        for (int i = 0; i < count; i++) {
+            neighbours[i] = make_pair(distance(samples[i], features), samples[i].best);
+        }
+        sort(neighbours, neighbours + count);
+        
+        // Inverse squared distance vote among the k nearest
+        double votes[ALGO_TYPE_COUNT] = {};
+        for (int i = 0; i < min(k, count); i++) {
+            votes[neighbours[i].second] += 1.0 / (neighbours[i].first * neighbours[i].first + 1e-5);
+        }
+        AlgoType choice = neighbours[0].second;
+        for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+            if (votes[a] > votes[choice]) choice = (AlgoType)a;
+        }
+        
+        // Safety rule: no quadratic engine on large inputs
+        if (choice == INSERTION_SORT && features.size > 1000) return VECTOR_QUICK_SORT;
+        return choice;
+    }
+
+private:
+    int k;
+    vector<Sample> samples;
+
+    static double distance(const Sample& sample, const DatasetFeatures& features) {
+        double dSize = (log10(max(sample.size, 1)) - log10(max(features.size, 1))) / 7.0;
+        double dSort = sample.sortedness - features.sortedness;
+        double dRev = sample.reversedness - features.reversedness;
+        double dUniq = sample.uniqueRatio - features.uniqueRatio;
+        return sqrt(dSize * dSize * 1.5 + dSort * dSort * 2.0 + dRev * dRev * 2.0 + dUniq * dUniq);
+    }
+};
+
+// Estimated nanoseconds per element for each engine, from its complexity
+// and constants measured with single runs on fresh random and few-unique
+// inputs of 256 to 10^6 elements (repeating one input lets the branch
+// predictor learn it, which flatters small sorts); picks the cheapest
+// estimate. Quick sorts pay per level of distinct keys (duplicate runs are
+// dropped) and the vector partition's leaf networks only see distinct keys,
+// radix sort pays a fixed four passes plus its histograms, and merges and
+// radix scatters slow down once the data outgrows L2.
+class CostModelSelector : public Selector {
+public:
+    string name() const { return "cost"; }
+
+    AlgoType predict(const DatasetFeatures& features) const {
+        AlgoType choice = RADIX_SORT;
+        double cheapest = estimate(RADIX_SORT, features);
+        for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+            double cost = estimate((AlgoType)a, features);
+            if (cost < cheapest) {
+                cheapest = cost;
+                choice = (AlgoType)a;
+            }
+        }
+        return choice;
+    }
+
+    // Estimated ns per element (1e18 for engines that are not considered)
+    static double estimate(AlgoType algo, const DatasetFeatures& features) {
+        double n = max(features.size, 2);
+        double levels = log2(n);
+        double unique = min(1.0, features.uniqueRatio);
+        double keyLevels = 1 + min(levels, log2(max(2.0, unique * n)));
+        double l2Keys = SortingEngine::cacheSizes().l2 / sizeof(int) / 4.0;
+        double cacheFactor = 1 + n / (n + l2Keys);
+        
+        switch (algo) {
+            case INSERTION_SORT:
+                // One shift per inversion; the sampled ratio cannot rule out a
+                // few long moves on large inputs, so never there
+                if (features.size > 1000) break;
+                return 2 + 1.2 * n * features.inversionRatio;
+            case MERGE_SORT:
+                return 3.5 * levels * cacheFactor * (0.5 + 0.5 * unique);
+            case BLOCKED_MERGE_SORT:
+            case BRANCHLESS_MERGE_SORT:
+                return 2.5 * levels * cacheFactor;
+            case BLOCK_QUICK_SORT:
+                return 3.3 * keyLevels + 1000 / n;
+            case VECTOR_QUICK_SORT: {
+                if (!SortingEngine::hasAvx2()) return estimate(BLOCK_QUICK_SORT, features);
+                double perLevel = SortingEngine::hasAvx512() ? 0.7 : 1.0;
+                return 10 * unique + perLevel * keyLevels + 1000 / n;
+            }
+            case RADIX_SORT:
+                return 14 + 2000 / n + 22 * unique * n / (n + l2Keys);
+            case RUN_MERGE_SORT: {
+                // Runs shorter than a leaf are leaf-sorted first, then one merge
+                // level per doubling, through a buffer once there are two runs
+                double leaf = SortingEngine::leafSize(0);
+                double runs = min(max(1.0, (double)features.runs), max(1.0, n / leaf));
+                double leafCost = (features.runs > n / leaf) ? 2.5 * log2(leaf) : 0;
+                return (runs > 1 ? 5 : 3) + leafCost + 3.2 * log2(runs) * cacheFactor;
+            }
+            case COUNTING_SORT: {
+                // Zeroing and scanning the count table, plus cache misses on it
+                // once it outgrows L2 when the order jumps around (many short runs)
+                double span = (double)features.maxValue - features.minValue + 1;
+                if (span > SortingEngine::COUNTING_MAX_SPAN) return estimate(RADIX_SORT, features);
+                double scattered = min(1.0, 2.5 * features.runs / n);
+                return 3.5 + 3 * span / n + 8 * scattered * span / (span + l2Keys);
+            }
+            case PREFIX_MERGE: {
+                // The prefix is scanned, the tail merge sorted (radix sorted past
+                // 1000 elements) and merged back through a buffer
+                if (features.sortedPrefixLength < features.size / 2 ||
+                    features.sortedPrefixLength >= features.size) break;
+                DatasetFeatures tail = features;
+                tail.size = features.size - features.sortedPrefixLength;
+                return 3 + tail.size / n * (5 + estimate(tail.size > 1000 ? RADIX_SORT : MERGE_SORT, tail));
+            }
+            default:
+                break;
+        }
+        return 1e18;
+    }
+};
+
+// Fallback for ambiguous features. Mid-range sortedness with medium
+// uniqueness is where a fixed threshold (such as uniqueRatio < 0.40) decides
+// between engines that are close, and which one wins depends on the
+// hardware. There the probe sorts a random sample with the base pick and
+// the two engines the cost model ranks next (fastest of a few samples),
+// and scales each
+// time to the full input by the cost model's curve for that engine. The
+// sample is as large as fits in PROBE_BUDGET of the expected sort time;
+// when even MIN_SAMPLE elements do not fit, the base pick is used as is.
+class ProbeSelector : public Selector {
+public:
+    static const int MIN_SAMPLE = 256;
+    static const int MAX_SAMPLE = 1 << 16;
+    static const int CANDIDATES = 3;
+    static const int PROBE_RUNS = 3;      // Samples sorted and timed per candidate
+    static constexpr double PROBE_BUDGET = 0.01;
+
+    struct Probe {
+        int sampleSize = 0;                            // 0 when the features were not ambiguous
+        vector<pair<AlgoType, double> > extrapolated;  // Predicted full-sort ms per candidate
+        double probeMs = 0;
+    };
+
+    explicit ProbeSelector(unique_ptr<Selector> base) : base(move(base)) {}
+
+    string name() const { return base->name() + "+probe"; }
+    AlgoType predict(const DatasetFeatures& features) const { return base->predict(features); }
+
+    AlgoType predictOn(const vector<int>& data, const DatasetFeatures& features, double* overheadMs = nullptr) const {
+        Probe probe;
+        AlgoType choice = run(data, features, probe);
+        if (overheadMs) *overheadMs = probe.probeMs;
+        return choice;
+    }
+
+    static bool ambiguous(const DatasetFeatures& features) {
+        return features.sortedness >= 0.30 && features.sortedness <= 0.70 &&
+               features.uniqueRatio >= 0.10 && features.uniqueRatio <= 0.90 &&
+               features.sortedPrefixLength < features.size / 2;
+    }
+
+    // Probe (when the features are ambiguous) and return the pick
+    AlgoType run(const vector<int>& data, const DatasetFeatures& features, Probe& probe) const {
+        AlgoType pick = base->predict(features);
+        if (!ambiguous(features)) return pick;
+        
+        // Base pick first, then the cheapest other engines by the cost model
+        vector<pair<double, AlgoType> > ranked;
+        for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+            double cost = CostModelSelector::estimate((AlgoType)a, features);
+            if ((AlgoType)a != pick && cost < 1e18) ranked.push_back(make_pair(cost, (AlgoType)a));
+        }
+        sort(ranked.begin(), ranked.end());
+        vector<AlgoType> candidates(1, pick);
+        for (size_t i = 0; i < ranked.size() && (int)candidates.size() < CANDIDATES; i++) {
+            candidates.push_back(ranked[i].second);
+        }
+        
+        // Largest power-of-two sample whose estimated probe cost fits the budget
+        double budgetNs = PROBE_BUDGET * CostModelSelector::estimate(pick, features) * features.size;
+        int sampleSize = 0;
+        for (int m = MIN_SAMPLE; m <= min((int)MAX_SAMPLE, features.size / 4); m *= 2) {
+            if (probeCostNs(candidates, features, m) > budgetNs) break;
+            sampleSize = m;
+        }
+        if (sampleSize == 0) return pick;
+        
+        // Buffers come first, so the clock covers drawing and sorting only
+        ScratchArena::Scope scratch;
+        int* samples = ScratchArena::local().allocate<int>(PROBE_RUNS * sampleSize);
+        int* copy = ScratchArena::local().allocate<int>(sampleSize);
+        auto start = chrono::steady_clock::now();
+        Rng rng(SortingEngine::pivotSeed() ^ (uint64_t)data.size());
+        for (int i = 0; i < PROBE_RUNS * sampleSize; i++) samples[i] = data[rng.below((uint32_t)data.size())];
+        DatasetFeatures sampleFeatures = scaled(features, sampleSize);
+        
+        AlgoType choice = pick;
+        double bestMs = 0;
+        for (AlgoType algo : candidates) {
+            // Fastest of PROBE_RUNS samples: the first run of a small sort
+            // also pays for cold caches and code, which the full sort
+            // amortises. Each run gets its own sample, since re-sorting one
+            // sample lets the branch predictor learn it.
+            double sampleMs = 1e18;
+            for (int run = 0; run < PROBE_RUNS; run++) {
+                long long comparisons = 0;
+                std::copy(samples + run * sampleSize, samples + (run + 1) * sampleSize, copy);
+                auto sortStart = chrono::steady_clock::now();
+                SortingEngine::sortWith(algo, copy, sampleSize, comparisons);
+                sampleMs = min(sampleMs, chrono::duration<double, milli>(chrono::steady_clock::now() - sortStart).count());
+            }
+            
+            double ms = sampleMs * CostModelSelector::estimate(algo, features) * features.size /
+                        (CostModelSelector::estimate(algo, sampleFeatures) * sampleSize);
+            probe.extrapolated.push_back(make_pair(algo, ms));
+            if (algo == pick || ms < bestMs) {
+                bestMs = ms;
+                choice = algo;
+            }
+        }
+        probe.sampleSize = sampleSize;
+        probe.probeMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return choice;
+    }
+
+private:
+    unique_ptr<Selector> base;
+
+    // Features of a random sample of m elements: the same shape, fewer keys
+    static DatasetFeatures scaled(const DatasetFeatures& features, int m) {
+        DatasetFeatures sample = features;
+        sample.size = m;
+        sample.uniqueRatio = min(1.0, features.uniqueRatio * features.size / m);
+        sample.sortedPrefixLength = 0;
+        // Drawn in random order: no long runs, half the pairs inverted
+        sample.runs = max(1, m * 2 / 5);
+        sample.longestRun = min(features.longestRun, 8);
+        sample.inversionRatio = 0.5 * min(1.0, sample.uniqueRatio);
+        return sample;
+    }
+
+    // Estimated ns to draw the samples and sort each with every candidate
+    static double probeCostNs(const vector<AlgoType>& candidates, const DatasetFeatures& features, int m) {
+        DatasetFeatures sample = scaled(features, m);
+        double ns = 5.0 * PROBE_RUNS * m;
+        for (AlgoType algo : candidates) ns += PROBE_RUNS * (CostModelSelector::estimate(algo, sample) + 1) * m;
+        return ns;
+    }
+};
+
+// A selector compiled into a flat lookup table. At construction the source
+// is asked once for the centre of every cell of a grid over size (quarter
+// octaves of log2), sortedness, reversedness and uniqueness (eighths each);
+// predict() is then a count-leading-zeros, a few shifts and one load, with
+// no floating point: the ratios arrive quantised in features.ratioCells.
+// Only for sources that read nothing but those four features (the k-NN
+// vote). The table is checked against the source on a test lattice whose
+// points sit off the cell centres. Every cell that disagrees at a test point
+// is rebuilt from the majority answer over 4 x 4 x 4 x 4 points inside it,
+// and a table that still agrees on fewer than MIN_AGREEMENT of the points is
+// rejected with runtime_error.
+class TableSelector : public Selector {
+public:
+    static const int SIZE_CELLS = 4 * 32;   // Quarter octaves of 1 .. 2^32
+    static const int RATIO_BITS = SortingEngine::RATIO_BITS;
+    static const int RATIO_CELLS = 1 << RATIO_BITS;
+    static constexpr double MIN_AGREEMENT = 0.97;
+
+    explicit TableSelector(unique_ptr<Selector> source)
+        : source(move(source)), table(SIZE_CELLS << (3 * RATIO_BITS)) {
+        for (int cell = 0; cell < (int)table.size(); cell++) {
+            table[cell] = (uint8_t)this->source->predict(cellPoint(cell, 0.5, 0.5, 0.5, 0.5));
+        }
+        vector<int> disagreeing = check();
+        for (int cell : disagreeing) repair(cell);
+        repaired = (int)disagreeing.size();
+        if (repaired > 0) check();
+        if (agreed < MIN_AGREEMENT) {
+            throw runtime_error("Decision table for " + this->source->name() + " agrees with it on only "
+                                + to_string((int)(agreed * 1000) / 10.0) + "% of the test points");
+        }
+    }
+
+    string name() const { return source->name() + "+table"; }
+
+    AlgoType predict(const DatasetFeatures& features) const {
+        return (AlgoType)table[(sizeCell(features.size) << (3 * RATIO_BITS)) | features.ratioCells];
+    }
+
+    int cells() const { return (int)table.size(); }
+    int testPoints() const { return points; }
+    double agreement() const { return agreed; }
+    int repairedCells() const { return repaired; }
+
+private:
+    unique_ptr<Selector> source;
+    vector<uint8_t> table;
+    int points = 0;
+    double agreed = 0;
+    int repaired = 0;
+
+    // Octave in the high bits, the two bits below the leading one in the low bits
+    static int sizeCell(int size) {
+        uint32_t n = (uint32_t)max(size, 1);
+        int octave = SortingEngine::bitWidth(n) - 1;
+        return (octave << 2) | (int)((((uint64_t)n << 2) >> octave) & 3);
+    }
+
+    // The point at fractions (0..1) of the way across a cell in each dimension
+    static DatasetFeatures cellPoint(int cell, double atSize, double atSorted, double atReversed, double atUnique) {
+        int mask = RATIO_CELLS - 1;
+        int sizeIndex = cell >> (3 * RATIO_BITS);
+        double size = ldexp(1.0 + ((sizeIndex & 3) + atSize) / 4, sizeIndex >> 2);
+        return point((int)min(size, (double)INT_MAX), (((cell >> (2 * RATIO_BITS)) & mask) + atSorted) / RATIO_CELLS,
+                     (((cell >> RATIO_BITS) & mask) + atReversed) / RATIO_CELLS, ((cell & mask) + atUnique) / RATIO_CELLS);
+    }
+
+    // Features with only the four table inputs meaningful; the rest are set
+    // to what a random input of that size would show
+    static DatasetFeatures point(int size, double sorted, double reversed, double unique) {
+        DatasetFeatures f;
+        f.size = size;
+        f.isLargeDataset = (size > 1000);
+        f.sortedness = sorted;
+        f.reversedness = reversed;
+        f.uniqueRatio = unique;
+        f.uniqueCount = (int)(unique * size);
+        f.minValue = 0;
+        f.maxValue = INT_MAX;
+        f.sortedPrefixLength = 0;
+        f.runs = max(1, size * 2 / 5);
+        f.longestRun = min(size, 8);
+        f.inversionRatio = f.remRatio = 0.5;
+        f.entropyBits = log2(max(1.0, unique * size));
+        f.rangeBits = 31;
+        SortingEngine::classifyDataset(f);
+        return f;
+    }
+
+    // Sizes three per decade from 10 to 10^7, ratios at five levels that
+    // avoid the cell centres. Returns the cells that disagreed.
+    vector<int> check() {
+        const double levels[] = {0.03, 0.2, 0.45, 0.7, 0.97};
+        vector<int> disagreeing;
+        int agree = 0;
+        points = 0;
+        for (double size = 10; size <= 1e7; size *= 2.154) {
+            for (double sorted : levels) {
+                for (double reversed : levels) {
+                    for (double unique : levels) {
+                        DatasetFeatures f = point((int)size, sorted, reversed, unique);
+                        if (predict(f) == source->predict(f)) {
+                            agree++;
+                        } else {
+                            disagreeing.push_back((sizeCell(f.size) << (3 * RATIO_BITS)) | f.ratioCells);
+                        }
+                        points++;
+                    }
+                }
+            }
+        }
+        agreed = (double)agree / points;
+        sort(disagreeing.begin(), disagreeing.end());
+        disagreeing.erase(unique(disagreeing.begin(), disagreeing.end()), disagreeing.end());
+        return disagreeing;
+    }
+
+    // The source's most common answer over 4 points per dimension inside the cell
+    void repair(int cell) {
+        int votes[ALGO_TYPE_COUNT] = {};
+        for (int i = 0; i < 256; i++) {
+            DatasetFeatures f = cellPoint(cell, ((i & 3) + 0.5) / 4, (((i >> 2) & 3) + 0.5) / 4,
+                                          (((i >> 4) & 3) + 0.5) / 4, ((i >> 6) + 0.5) / 4);
+            votes[source->predict(f)]++;
+        }
+        table[cell] = (uint8_t)(max_element(votes, votes + ALGO_TYPE_COUNT) - votes);
+    }
+};
+
+// Strategy names accepted by makeSelector ("probe" is the rules with the
+// probe fallback, "table" the k-NN vote compiled into a TableSelector)
+const vector<string>& selectorNames() {
+    static const vector<string> names = {"rules", "knn", "cost", "probe", "table"};
+    return names;
+}
+
+unique_ptr<Selector> makeSelector(const string& name) {
+    if (name == "rules") return unique_ptr<Selector>(new RuleSelector());
+    if (name == "knn") return unique_ptr<Selector>(new KnnSelector());
+    if (name == "cost") return unique_ptr<Selector>(new CostModelSelector());
+    if (name == "probe") return unique_ptr<Selector>(new ProbeSelector(makeSelector("rules")));
+    if (name == "table") return unique_ptr<Selector>(new TableSelector(makeSelector("knn")));
+    throw invalid_argument("Unknown selector: " + name + " (expected rules, knn, cost, probe or table)");
+}
+
+// ============= Online Selection =============
+
+// Epsilon-greedy bandit over the sorting engines, learning from measured
+// runs. Inputs are bucketed by quantised features (size decade, four
+// sortedness and four uniqueness levels, reversed and sorted-prefix flags;
+// the level edges keep common shapes such as random data, whose sortedness
+// is about 0.5, away from a boundary), and every
+// bucket keeps the cost of each engine in nanoseconds per element as a
+// running mean that turns into a moving average after MEMORY samples, so
+// it follows drifting traffic. choose() returns the cheapest measured
+// engine of the bucket, the prior's pick until that has been measured, or
+// with probability epsilon a random engine. record() only uses atomic
+// read-modify-write operations, so concurrent sorters can share one
+// selector without locking.
+class OnlineSelector : public Selector {
+public:
+    static const int BUCKETS = 8 * 4 * 4 * 2 * 2;
+    static const int MEMORY = 20;       // Samples before old runs start to fade
+
+    typedef function<AlgoType(const DatasetFeatures&)> Prior;
+
+    explicit OnlineSelector(double epsilon = 0.05, Prior prior = SortingEngine::predictBestAlgorithm)
+        : epsilon(epsilon), prior(prior), arms(BUCKETS * ALGO_TYPE_COUNT) {
+        for (Arm& arm : arms) {
+            arm.samples.store(0);
+            arm.nsPerElement.store(0.0);
+        }
+    }
+
+    static int bucketOf(const DatasetFeatures& features) {
+        int sizeClass = 0;
+        for (long long limit = 10; sizeClass < 7 && features.size >= limit; limit *= 10) sizeClass++;
+        int sorted = level(features.sortedness, 0.10, 0.90, 0.99);
+        int unique = level(features.uniqueRatio, 0.01, 0.40, 0.90);
+        int reversed = features.reversedness >= 0.90 ? 1 : 0;
+        int prefix = (features.sortedPrefixLength >= features.size / 2 &&
+                      features.sortedPrefixLength < features.size) ? 1 : 0;
+        return (((sizeClass * 4 + sorted) * 4 + unique) * 2 + reversed) * 2 + prefix;
+    }
+
+    // Engines the selector may pick or explore for an input of this size.
+    // Bubble sort and the Lomuto quick sort have quadratic inputs, and the
+    // top-k kernels are not full sorts.
+    static bool isArm(AlgoType algo, int size) {
+        switch (algo) {
+            case INSERTION_SORT: return size <= 1000;
+            case MERGE_SORT:
+            case BLOCKED_MERGE_SORT:
+            case BRANCHLESS_MERGE_SORT:
+            case BLOCK_QUICK_SORT:
+            case VECTOR_QUICK_SORT:
+            case RADIX_SORT:
+            case RUN_MERGE_SORT:
+            case COUNTING_SORT:
+            case PREFIX_MERGE: return true;
+            default: return false;
+        }
+    }
+
+    string name() const { return "online"; }
+    AlgoType predict(const DatasetFeatures& features) const { return best(features); }
+
+    // Cheapest measured engine for these features (no exploration)
+    AlgoType best(const DatasetFeatures& features) const {
+        int bucket = bucketOf(features);
+        AlgoType choice = prior(features);
+        if (!isArm(choice, features.size) || samples(bucket, choice) == 0) return choice;
+        double bestCost = cost(bucket, choice);
+        for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+            if (!isArm((AlgoType)a, features.size) || samples(bucket, (AlgoType)a) == 0) continue;
+            if (cost(bucket, (AlgoType)a) < bestCost) {
+                bestCost = cost(bucket, (AlgoType)a);
+                choice = (AlgoType)a;
+            }
+        }
+        return choice;
+    }
+
+    // Engine to run next: best() most of the time, a random engine with
+    // probability epsilon (*explored is set accordingly)
+    AlgoType choose(const DatasetFeatures& features, bool* explored = nullptr) {
+        Rng& rng = explorationRng();
+        bool explore = rng.uniform() < epsilon;
+        if (explored) *explored = explore;
+        if (!explore) return best(features);
+        
+        vector<AlgoType> candidates;
+        for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+            if (isArm((AlgoType)a, features.size)) candidates.push_back((AlgoType)a);
+        }
+        return candidates[rng.below((uint32_t)candidates.size())];
+    }
+
+    // Fold one measured run into its bucket
+    void record(const DatasetFeatures& features, AlgoType algo, double ms) {
+        if (!isArm(algo, features.size) || features.size <= 0) return;
+        Arm& arm = at(bucketOf(features), algo);
+        double sample = ms * 1e6 / features.size;
+        long long n = arm.samples.fetch_add(1) + 1;
+        double weight = 1.0 / min<long long>(n, MEMORY);
+        double mean = arm.nsPerElement.load();
+        while (!arm.nsPerElement.compare_exchange_weak(mean, mean + weight * (sample - mean))) {
+        }
+    }
+
+    long long samples(int bucket, AlgoType algo) const { return at(bucket, algo).samples.load(); }
+    double cost(int bucket, AlgoType algo) const { return at(bucket, algo).nsPerElement.load(); }
+
+    // Text state, one measured (bucket, engine) per line. Engines are stored
+    // by name, so files survive changes to the AlgoType order.
+    void save(const string& path) const {
+        string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "w");
+        if (!file) throw runtime_error("Cannot write " + temp);
+        fprintf(file, "# online selector: bucket samples ns/element engine\n");
+        for (int b = 0; b < BUCKETS; b++) {
+            for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+                long long n = samples(b, (AlgoType)a);
+                if (n == 0) continue;
+                fprintf(file, "%d %lld %.6f %s\n", b, n, cost(b, (AlgoType)a),
+                        SortingEngine::getAlgoName((AlgoType)a).c_str());
+            }
+        }
+        bool failed = ferror(file) != 0;
+        if (fclose(file) != 0 || failed) throw runtime_error("Cannot write " + temp);
+        if (rename(temp.c_str(), path.c_str()) != 0) {
+            remove(path.c_str());
+            if (rename(temp.c_str(), path.c_str()) != 0) throw runtime_error("Cannot replace " + path);
+        }
+    }
+
+    // Merge a saved state into this one; returns false when the file does not exist
+    bool load(const string& path) {
+        FILE* file = fopen(path.c_str(), "r");
+        if (!file) return false;
+        char line[256];
+        int lineNumber = 0;
+        while (fgets(line, sizeof(line), file)) {
+            lineNumber++;
+            if (line[0] == '#' || line[0] == '\n') continue;
+            int bucket = -1, consumed = 0;
+            long long n = 0;
+            double nsPerElement = 0;
+            if (sscanf(line, "%d %lld %lf %n", &bucket, &n, &nsPerElement, &consumed) < 3 ||
+                bucket < 0 || bucket >= BUCKETS || n <= 0) {
+                fclose(file);
+                throw runtime_error(path + ":" + to_string(lineNumber) + ": malformed selector state");
+            }
+            string name = line + consumed;
+            while (!name.empty() && (name.back() == '\n' || name.back() == '\r')) name.pop_back();
+            for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+                if (SortingEngine::getAlgoName((AlgoType)a) == name) {
+                    at(bucket, (AlgoType)a).samples.store(n);
+                    at(bucket, (AlgoType)a).nsPerElement.store(nsPerElement);
+                }
+            }
+        }
+        fclose(file);
+        return true;
+    }
+
+private:
+    struct Arm {
+        atomic<long long> samples;
+        atomic<double> nsPerElement;
+    };
+
+    double epsilon;
+    Prior prior;
+    vector<Arm> arms;
+
+    static int level(double value, double first, double second, double third) {
+        return (value >= first) + (value >= second) + (value >= third);
+    }
+
+    Arm& at(int bucket, AlgoType algo) { return arms[bucket * ALGO_TYPE_COUNT + algo]; }
+    const Arm& at(int bucket, AlgoType algo) const { return arms[bucket * ALGO_TYPE_COUNT + algo]; }
+
+    static Rng& explorationRng() {
+        thread_local Rng rng(SortingEngine::randomSeed());
+        return rng;
+    }
+};
+
+// ============= Memory-Mapped Datasets =============
+
+// Raw int32 array (native byte order, little-endian on x86) backed by a
+// memory-mapped file. Analysis and sorting run directly on the mapped pages
+// and, for writable mappings, the result lands in the file without a copy.
+class MappedIntFile {
+public:
+    enum Mode {
+        READ_ONLY,      // Existing file, private copy-on-write pages
+        READ_WRITE,     // Existing file, changes are written back
+        CREATE          // New file of a given size, changes are written back
+    };
+
+    enum Advice {
+        ADVISE_NORMAL,
+        ADVISE_SEQUENTIAL,  // Linear scans (analysis, merging)
+        ADVISE_RANDOM,      // Scattered access (quick sort partitions)
+        ADVISE_WILLNEED     // Start reading ahead now
+    };
+
+    struct Options {
+        bool populate;      // Pre-fault every page at map time (MAP_POPULATE)
+        bool hugePages;     // Ask for transparent huge pages (MADV_HUGEPAGE)
+        Options() : populate(false), hugePages(false) {}
+    };
+
+    MappedIntFile(const string& path, Mode mode, size_t createElements = 0, Options options = Options())
+        : ptr(nullptr), count(0), bytes(0), writable(mode != READ_ONLY) {
+        map(path, mode, createElements, options);
+    }
+
+    ~MappedIntFile() { unmap(); }
+
+    int* data() { return ptr; }
+    const int* data() const { return ptr; }
+    int size() const { return (int)count; }
+
+    // Hint the kernel about the coming access pattern (no-op where unsupported)
+    void advise(Advice advice) {
+#if defined(__unix__) || defined(__APPLE__)
+        if (bytes == 0) return;
+        int flag = MADV_NORMAL;
+        if (advice == ADVISE_SEQUENTIAL) flag = MADV_SEQUENTIAL;
+        else if (advice == ADVISE_RANDOM) flag = MADV_RANDOM;
+        else if (advice == ADVISE_WILLNEED) flag = MADV_WILLNEED;
+        madvise(ptr, bytes, flag);
+#else
+        (void)advice;
+#endif
+    }
+
+    // Flush modified pages to the file
+    void sync() {
+        if (!writable || bytes == 0) return;
+#if defined(__unix__) || defined(__APPLE__)
+        if (msync(ptr, bytes, MS_SYNC) != 0) throw runtime_error("msync failed");
+#elif defined(_WIN32)
+        if (!FlushViewOfFile(ptr, 0) || !FlushFileBuffers(fileHandle)) throw runtime_error("FlushViewOfFile failed");
+#endif
+    }
+
+private:
+    int* ptr;
+    size_t count;
+    size_t bytes;
+    bool writable;
+#if defined(_WIN32)
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+    MappedIntFile(const MappedIntFile&);
+    MappedIntFile& operator=(const MappedIntFile&);
+
+    void map(const string& path, Mode mode, size_t createElements, const Options& options) {
+#if defined(__unix__) || defined(__APPLE__)
+        int flags = (mode == READ_ONLY) ? O_RDONLY : (mode == READ_WRITE ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC);
+        int fd = open(path.c_str(), flags, 0644);
+        if (fd < 0) throw runtime_error("Cannot open " + path);
+        
+        if (mode == CREATE) {
+            bytes = createElements * sizeof(int);
+            if (ftruncate(fd, bytes) != 0) {
+                close(fd);
+                throw runtime_error("Cannot resize " + path);
+            }
+        } else {
+            struct stat st;
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw runtime_error("Cannot stat " + path);
+            }
+            bytes = (size_t)st.st_size / sizeof(int) * sizeof(int);
+        }
+        count = bytes / sizeof(int);
+        if (count > (size_t)INT_MAX) {
+            close(fd);
+            throw runtime_error(path + " holds more than INT_MAX elements");
+        }
+        if (bytes == 0) {
+            close(fd);
+            return;
+        }
+        
+        int mapFlags = (mode == READ_ONLY) ? MAP_PRIVATE : MAP_SHARED;
+#if defined(MAP_POPULATE)
+        if (options.populate) mapFlags |= MAP_POPULATE;
+#endif
+        void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+        close(fd);      // The mapping keeps the file referenced
+        if (addr == MAP_FAILED) throw runtime_error("mmap failed for " + path);
+        ptr = static_cast<int*>(addr);
+#if defined(MADV_HUGEPAGE)
+        if (options.hugePages) madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+#elif defined(_WIN32)
+        (void)options;
+        DWORD access = (mode == READ_ONLY) ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+        DWORD disposition = (mode == CREATE) ? CREATE_ALWAYS : OPEN_EXISTING;
+        fileHandle = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr, disposition,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) throw runtime_error("Cannot open " + path);
+        
+        LARGE_INTEGER fileSize;
+        if (mode == CREATE) {
+            fileSize.QuadPart = (LONGLONG)(createElements * sizeof(int));
+        } else if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            unmap();
+            throw runtime_error("Cannot stat " + path);
+        }
+        bytes = (size_t)fileSize.QuadPart / sizeof(int) * sizeof(int);
+        count = bytes / sizeof(int);
+        if (count > (size_t)INT_MAX) {
+            unmap();
+            throw runtime_error(path + " holds more than INT_MAX elements");
+        }
+        if (bytes == 0) return;
+        
+        DWORD protect = (mode == READ_ONLY) ? PAGE_WRITECOPY : PAGE_READWRITE;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, protect,
+                                           (DWORD)((uint64_t)bytes >> 32), (DWORD)bytes, nullptr);
+        if (!mappingHandle) {
+            unmap();
+            throw runtime_error("CreateFileMapping failed for " + path);
+        }
+        DWORD viewAccess = (mode == READ_ONLY) ? FILE_MAP_COPY : FILE_MAP_WRITE;
+        ptr = static_cast<int*>(MapViewOfFile(mappingHandle, viewAccess, 0, 0, bytes));
+        if (!ptr) {
+            unmap();
+            throw runtime_error("MapViewOfFile failed for " + path);
+        }
+#else
+        (void)path; (void)mode; (void)createElements; (void)options;
+        throw runtime_error("Memory-mapped files are not supported on this platform");
+#endif
+    }
+
+    void unmap() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (ptr) munmap(ptr, bytes);
+#elif defined(_WIN32)
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mappingHandle) CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+        mappingHandle = nullptr;
+        fileHandle = INVALID_HANDLE_VALUE;
+#endif
+        ptr = nullptr;
+    }
+};
+
+// ============= NUMA-Aware Parallel Sort =============
+
+// Memory nodes and the logical cores on each, limited to the cores this
+// process may run on (nodes left without any are dropped)
+struct NumaTopology {
+    vector<int> nodeIds;                // OS number of each node
+    vector<vector<int> > nodeCores;     // Cores of each node
+    string source;                      // "libnuma", "sysfs", "simulated" or "single node"
+
+    int nodes() const { return (int)nodeCores.size(); }
+
+    int cores() const {
+        int total = 0;
+        for (const vector<int>& cores : nodeCores) total += (int)cores.size();
+        return total;
+    }
+};
+
+struct NumaSortStats {
+    int workers = 0;                    // Sorting threads, one per core
+    bool nodeAware = false;             // Pinned workers and node-local buffers
+    bool boundByLibnuma = false;        // Buffers bound with libnuma rather than by first touch
+    vector<long long> nodeElements;     // Output elements each node sorted
+    long long comparisons = 0;
+    double countMs = 0.0;               // Splitters and per-chunk histograms
+    double touchMs = 0.0;               // First touch of the node buffers
+    double scatterMs = 0.0;             // Chunks moved into their key ranges
+    double sortMs = 0.0;                // Local analysis and sort, and the copy back
+    double totalMs = 0.0;
+};
+
+// Anonymous memory for `count` ints meant for one node (node < 0: no
+// preference). With libnuma (-DHAVE_LIBNUMA, link -lnuma) it is bound to the
+// node; otherwise the pages are mapped but not touched, so the first thread
+// to write each page, a worker pinned to the node, decides where it lives.
+class NodeMemory {
+public:
+    NodeMemory(size_t count, int node) : ptr(nullptr), bytes(count * sizeof(int)), kind(HEAP) {
+        if (bytes == 0) return;
+#if defined(HAVE_LIBNUMA)
+        if (node >= 0 && numa_available() >= 0) {
+            ptr = static_cast<int*>(numa_alloc_onnode(bytes, node));
+            if (ptr) {
+                kind = LIBNUMA;
+                return;
+            }
+        }
+#else
+        (void)node;
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+        void* addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) throw runtime_error("mmap failed for a node buffer");
+        ptr = static_cast<int*>(addr);
+        kind = MAPPED;
+#else
+        ptr = static_cast<int*>(::operator new(bytes));
+#endif
+    }
+
+    ~NodeMemory() {
+        if (!ptr) return;
+#if defined(HAVE_LIBNUMA)
+        if (kind == LIBNUMA) numa_free(ptr, bytes);
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+        if (kind == MAPPED) munmap(ptr, bytes);
+#endif
+        if (kind == HEAP) ::operator delete(ptr);
+    }
+
+    int* data() { return ptr; }
+    bool boundByLibnuma() const { return kind == LIBNUMA; }
+
+private:
+    enum Kind { HEAP, MAPPED, LIBNUMA };
+
+    int* ptr;
+    size_t bytes;
+    Kind kind;
+
+    NodeMemory(const NodeMemory&);
+    NodeMemory& operator=(const NodeMemory&);
+};
+
+// Parallel sample sort that keeps each node's share of the work in that
+// node's memory. W workers, one per core and grouped by node, own W key
+// ranges cut by splitters from a sample, so every node owns one contiguous
+// stretch of the output. Four rounds of threads:
+//   1. count: worker w histograms input chunk w over the ranges. After
+//      placeInput(), chunk w sits on worker w's node, so this reads locally;
+//   2. touch: each worker writes its range of its node's buffer first, so
+//      the pages are allocated there (libnuma binds them outright);
+//   3. scatter: worker w moves chunk w into the ranges, the only pass that
+//      crosses the interconnect;
+//   4. sort: each worker sorts its range in place with the engine the rules
+//      pick for it, then copies it back. With even splitters range w ends up
+//      about where chunk w started, so the copy-back stays on the node too.
+// Keys equal to a splitter are dealt out by input index over every range that
+// splitter bounds, so heavy duplicates do not pile into one range.
+// With nodeAware false the same algorithm runs unpinned over one buffer
+// touched by the calling thread: the NUMA-oblivious baseline. With a single
+// worker there is nothing to split and the input is sorted in place.
+class NumaSorter {
+public:
+    static const int SAMPLE_PER_WORKER = 64;
+
+    // The machine's nodes: libnuma when built with it, else sysfs on Linux,
+    // else one node holding every core
+    static NumaTopology detect() {
+        vector<int> allowed = SortingEngine::availableCores();
+        NumaTopology topology;
+#if defined(HAVE_LIBNUMA)
+        if (numa_available() >= 0) {
+            topology.source = "libnuma";
+            for (int node = 0; node <= numa_max_node(); node++) {
+                vector<int> cores;
+                for (int core : allowed) {
+                    if (numa_node_of_cpu(core) == node) cores.push_back(core);
+                }
+                addNode(topology, node, cores);
+            }
+        }
+#endif
+#if defined(__linux__)
+        for (int node = 0; topology.source != "libnuma"; node++) {
+            string path = "/sys/devices/system/node/node" + to_string(node) + "/cpulist";
+            FILE* file = fopen(path.c_str(), "r");
+            if (!file) break;
+            char list[4096] = "";
+            if (!fgets(list, sizeof(list), file)) list[0] = '\0';
+            fclose(file);
+            topology.source = "sysfs";
+            vector<int> cores;
+            for (int core : parseCpuList(list)) {
+                if (find(allowed.begin(), allowed.end(), core) != allowed.end()) cores.push_back(core);
+            }
+            addNode(topology, node, cores);
+        }
+#endif
+        if (topology.nodes() == 0) {
+            topology = NumaTopology();
+            topology.source = "single node";
+            addNode(topology, 0, allowed);
+        }
+        return topology;
+    }
+
+    // `nodes` pretend nodes over the allowed cores (round robin, sharing cores
+    // when there are fewer cores than nodes), so the node-aware paths can be
+    // exercised on a single-node machine
+    static NumaTopology simulate(int nodes) {
+        vector<int> allowed = SortingEngine::availableCores();
+        NumaTopology topology;
+        topology.source = "simulated";
+        nodes = max(1, nodes);
+        for (int node = 0; node < nodes; node++) {
+            vector<int> cores;
+            for (size_t c = node; c < allowed.size(); c += nodes) cores.push_back(allowed[c]);
+            if (cores.empty()) cores.push_back(allowed[node % allowed.size()]);
+            addNode(topology, node, cores);
+        }
+        return topology;
+    }
+
+    // Copy src into fresh memory whose chunk w is first touched by worker w,
+    // so each node holds the slice its workers will read
+    static void placeInput(const int* src, int n, const NumaTopology& topology, NodeMemory& out) {
+        vector<int> cores = workerCores(topology);
+        int workers = (int)cores.size();
+        int* dst = out.data();
+        runWorkers(cores, true, [&](int w) {
+            long long begin = (long long)n * w / workers, end = (long long)n * (w + 1) / workers;
+            copy(src + begin, src + end, dst + begin);
+        });
+    }
+
+    // Sort data[0..n) with every core of the topology
+    static NumaSortStats sort(int* data, int n, const NumaTopology& topology, bool nodeAware = true) {
+        auto started = chrono::steady_clock::now();
+        auto lap = started;
+        auto elapsedMs = [&lap]() {
+            auto now = chrono::steady_clock::now();
+            double ms = chrono::duration<double, milli>(now - lap).count();
+            lap = now;
+            return ms;
+        };
+        
+        NumaSortStats stats;
+        vector<int> cores = workerCores(topology);
+        int workers = (int)cores.size();
+        stats.workers = workers;
+        stats.nodeAware = nodeAware;
+        vector<int> nodeOf;
+        for (int node = 0; node < topology.nodes(); node++) {
+            nodeOf.insert(nodeOf.end(), topology.nodeCores[node].size(), node);
+        }
+        stats.nodeElements.assign(topology.nodes(), 0);
+        
+        // One worker: the single-thread path, with no buffers, copies or threads
+        if (workers == 1) {
+            if (n > 1) {
+                AlgoType algo = SortingEngine::predictBestAlgorithm(SortingEngine::analyzeDataset(data, n, 1 << 16));
+                SortingEngine::sortWith(algo, data, n, stats.comparisons);
+            }
+            stats.nodeElements[nodeOf[0]] = n;
+            stats.sortMs = elapsedMs();
+            stats.totalMs = stats.sortMs;
+            return stats;
+        }
+        
+        // Splitters from a fixed-seed sample (the same input always gets the same ranges)
+        Rng rng(0x5A3B1E ^ (uint64_t)n, 2);
+        int sampleSize = min(n, SAMPLE_PER_WORKER * workers);
+        vector<int> sample(sampleSize);
+        for (int& key : sample) key = data[rng.below((uint32_t)n)];
+        std::sort(sample.begin(), sample.end());
+        vector<int> splitters;
+        for (int w = 1; w < workers && sampleSize > 0; w++) splitters.push_back(sample[(long long)sampleSize * w / workers]);
+        // Distinct splitters. Range r lies between splitters r - 1 and r, so a
+        // value repeated as splitters a .. b - 1 bounds ranges a .. b (those in
+        // between are empty) and its keys may go to any of them.
+        // firstRange[j]: first range bounds[j] may go to, closed by the splitter count
+        vector<int> bounds, firstRange;
+        for (int s = 0; s < (int)splitters.size(); s++) {
+            if (bounds.empty() || bounds.back() != splitters[s]) {
+                bounds.push_back(splitters[s]);
+                firstRange.push_back(s);
+            }
+        }
+        firstRange.push_back((int)splitters.size());
+        // Range of the key at input index i: keys equal to a splitter are dealt
+        // out by i, so the count and scatter passes agree on every element
+        auto rangeOf = [&bounds, &firstRange, n](int key, long long i) {
+            size_t j = lower_bound(bounds.begin(), bounds.end(), key) - bounds.begin();
+            if (j == bounds.size() || bounds[j] != key) return firstRange[j];
+            int span = firstRange[j + 1] - firstRange[j] + 1;
+            return firstRange[j] + (int)(i * span / n);
+        };
+        
+        // 1. counts[w][r]: elements of chunk w that fall in range r
+        vector<vector<long long> > counts(workers, vector<long long>(workers, 0));
+        auto chunkBegin = [n, workers](int w) { return (long long)n * w / workers; };
+        runWorkers(cores, nodeAware, [&](int w) {
+            vector<long long>& count = counts[w];
+            for (long long i = chunkBegin(w); i < chunkBegin(w + 1); i++) count[rangeOf(data[i], i)]++;
+        });
+        
+        // Output position of every range, and the slice each buffer holds:
+        // one buffer per node, or one shared buffer when not node-aware
+        vector<long long> rangeStart(workers + 1, 0);
+        for (int r = 0; r < workers; r++) {
+            rangeStart[r + 1] = rangeStart[r];
+            for (int w = 0; w < workers; w++) rangeStart[r + 1] += counts[w][r];
+        }
+        int buffers = nodeAware ? topology.nodes() : 1;
+        vector<long long> bufferStart(buffers + 1, n);
+        for (int r = workers - 1; r >= 0; r--) bufferStart[nodeAware ? nodeOf[r] : 0] = rangeStart[r];
+        vector<unique_ptr<NodeMemory> > memory;
+        for (int b = 0; b < buffers; b++) {
+            int node = nodeAware ? topology.nodeIds[b] : -1;
+            memory.push_back(unique_ptr<NodeMemory>(new NodeMemory(bufferStart[b + 1] - bufferStart[b], node)));
+            stats.boundByLibnuma = stats.boundByLibnuma || memory.back()->boundByLibnuma();
+        }
+        auto rangeData = [&](int r) {
+            int b = nodeAware ? nodeOf[r] : 0;
+            return memory[b]->data() + (rangeStart[r] - bufferStart[b]);
+        };
+        stats.countMs = elapsedMs();
+        
+        // 2. First touch: by each range's owner, or all by this thread
+        if (nodeAware) {
+            runWorkers(cores, true, [&](int w) {
+                fill(rangeData(w), rangeData(w) + (rangeStart[w + 1] - rangeStart[w]), 0);
+            });
+        } else if (n > 0) {
+            fill(rangeData(0), rangeData(0) + n, 0);
+        }
+        stats.touchMs = elapsedMs();
+        
+        // 3. Scatter: chunk w's share of range r goes after the earlier chunks' shares
+        runWorkers(cores, nodeAware, [&](int w) {
+            vector<int*> out(workers);
+            for (int r = 0; r < workers; r++) {
+                out[r] = rangeData(r);
+                for (int v = 0; v < w; v++) out[r] += counts[v][r];
+            }
+            for (long long i = chunkBegin(w); i < chunkBegin(w + 1); i++) {
+                int key = data[i];
+                *out[rangeOf(key, i)]++ = key;
+            }
+        });
+        stats.scatterMs = elapsedMs();
+        
+        // 4. Sort each range where it lies, then copy it back into place
+        vector<long long> comparisons(workers, 0);
+        runWorkers(cores, nodeAware, [&](int w) {
+            int* range = rangeData(w);
+            int length = (int)(rangeStart[w + 1] - rangeStart[w]);
+            if (length > 1) {
+                AlgoType algo = SortingEngine::predictBestAlgorithm(SortingEngine::analyzeDataset(range, length, 1 << 16));
+                SortingEngine::sortWith(algo, range, length, comparisons[w]);
+            }
+            copy(range, range + length, data + rangeStart[w]);
+        });
+        stats.sortMs = elapsedMs();
+        
+        for (int w = 0; w < workers; w++) {
+            stats.comparisons += comparisons[w];
+            stats.nodeElements[nodeOf[w]] += rangeStart[w + 1] - rangeStart[w];
+        }
+        stats.totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        return stats;
+    }
+
+private:
+    static void addNode(NumaTopology& topology, int node, const vector<int>& cores) {
+        if (cores.empty()) return;
+        topology.nodeIds.push_back(node);
+        topology.nodeCores.push_back(cores);
+    }
+
+    // Linux cpulist syntax: "0-3,8-11"
+    static vector<int> parseCpuList(const char* list) {
+        vector<int> cores;
+        const char* p = list;
+        while (*p) {
+            char* end = nullptr;
+            long first = strtol(p, &end, 10);
+            if (end == p) break;
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                last = strtol(p + 1, &end, 10);
+                p = end;
+            }
+            for (long c = first; c <= last; c++) cores.push_back((int)c);
+            if (*p != ',') break;
+            p++;
+        }
+        return cores;
+    }
+
+    // One worker per core, node by node
+    static vector<int> workerCores(const NumaTopology& topology) {
+        vector<int> cores;
+        for (const vector<int>& nodeCores : topology.nodeCores) cores.insert(cores.end(), nodeCores.begin(), nodeCores.end());
+        return cores;
+    }
+
+    // Run body(w) for every worker at once, pinned to its core when asked.
+    // The first exception thrown by a worker is rethrown here.
+    template <typename Body>
+    static void runWorkers(const vector<int>& cores, bool pin, Body body) {
+        vector<exception_ptr> errors(cores.size());
+        vector<thread> pool;
+        for (size_t w = 0; w < cores.size(); w++) {
+            pool.emplace_back([&, w]() {
+                try {
+                    if (pin) SortingEngine::pinThreadToCore(cores[w]);
+                    body((int)w);
+                } catch (...) {
+                    errors[w] = current_exception();
+                }
+            });
+        }
+        for (auto& th : pool) th.join();
+        for (const exception_ptr& error : errors) {
+            if (error) rethrow_exception(error);
+        }
+    }
+};
+
+// ============= External Merge Sort =============
+
+// Sequential reader for a binary file of native-endian (little-endian on x86) int32 values
+class IntFileReader {
+public:
+    IntFileReader(const string& path, size_t bufferElements)
+        : file(fopen(path.c_str(), "rb")), buffer(max<size_t>(bufferElements, 1)), pos(0), len(0) {
+        if (!file) throw runtime_error("Cannot open " + path + " for reading");
+    }
+    ~IntFileReader() { fclose(file); }
+
+    // Read up to `count` values into dest; returns the number read
+    size_t read(int* dest, size_t count) {
+        return fread(dest, sizeof(int), count, file);
+    }
+
+    // Next value through the internal buffer; false at end of file
+    bool next(int& value) {
+        if (pos == len) {
+            len = fread(buffer.data(), sizeof(int), buffer.size(), file);
+            pos = 0;
+            if (len == 0) return false;
+        }
+        value = buffer[pos++];
+        return true;
+    }
+
+private:
+    FILE* file;
+    vector<int> buffer;
+    size_t pos, len;
+
+    IntFileReader(const IntFileReader&);
+    IntFileReader& operator=(const IntFileReader&);
+};
+
+// Sequential writer for a binary file of int32 values
+class IntFileWriter {
+public:
+    IntFileWriter(const string& path, size_t bufferElements)
+        : file(fopen(path.c_str(), "wb")), buffer(max<size_t>(bufferElements, 1)), len(0), path(path) {
+        if (!file) throw runtime_error("Cannot open " + path + " for writing");
+    }
+    ~IntFileWriter() {
+        if (file) fclose(file);
+    }
+
+    void write(const int* src, size_t count) {
+        flush();
+        if (fwrite(src, sizeof(int), count, file) != count) throw runtime_error("Write failed: " + path);
+    }
+
+    void put(int value) {
+        buffer[len++] = value;
+        if (len == buffer.size()) flush();
+    }
+
+    void flush() {
+        if (len > 0 && fwrite(buffer.data(), sizeof(int), len, file) != len) {
+            throw runtime_error("Write failed: " + path);
+        }
+        len = 0;
+    }
+
+    void close() {
+        flush();
+        if (fclose(file) != 0) {
+            file = nullptr;
+            throw runtime_error("Write failed: " + path);
+        }
+        file = nullptr;
+    }
+
+private:
+    FILE* file;
+    vector<int> buffer;
+    size_t len;
+    string path;
+
+    IntFileWriter(const IntFileWriter&);
+    IntFileWriter& operator=(const IntFileWriter&);
+};
+
+struct ExternalSortStats {
+    long long elements = 0;             // Number of keys sorted
+    vector<AlgoType> runAlgorithms;     // Engine chosen for each in-memory run
+    int mergePasses = 0;                // 0 when the input fit in a single run
+    double runPhaseMs = 0.0;            // Read + analyze + sort + write runs
+    double mergePhaseMs = 0.0;          // K-way merge of the runs
+    double totalMs = 0.0;
+    double throughputMBps = 0.0;        // Input bytes / total time
+};
+
+// Out-of-core merge sort for files larger than the memory budget.
+// Phase 1 reads chunks that fit the budget, sorts each with the engine the
+// AI analysis recommends for that chunk and writes them as sorted runs.
+// Phase 2 merges the runs with a loser tree through large sequential buffers,
+// in several passes if there are more runs than the fan-in: at most
+// MAX_FAN_IN, and only as many as get MIN_BUFFER_ELEMENTS each (plus the
+// output's buffer) within the budget. Run files are removed even when a
+// step throws.
+class ExternalSorter {
+public:
+    static const int MAX_FAN_IN = 256;                      // Runs merged per pass
+    static const size_t MIN_BUFFER_ELEMENTS = 1 << 14;      // 64 KB per merge stream
+    static const size_t UNIQUE_SAMPLE = 1 << 16;            // Uniqueness sample per chunk
+
+    static ExternalSortStats sortFile(const string& inputPath, const string& outputPath,
+                                      size_t memoryBudgetBytes, const string& tempDir = "") {
+        ExternalSortStats stats;
+        auto start = chrono::steady_clock::now();
+        
+        // Chunks use half the budget: merge sort needs as much again for its buffers
+        size_t chunkElements = max<size_t>(memoryBudgetBytes / sizeof(int) / 2, MIN_BUFFER_ELEMENTS);
+        string runPrefix = (tempDir.empty() ? outputPath : tempDir + "/" + baseName(outputPath)) + ".run";
+        
+        // Phase 1: sorted runs
+        vector<string> runs;
+        TempFiles tempFiles;
+        {
+            IntFileReader reader(inputPath, 1);
+            vector<int> chunk(chunkElements);
+            while (true) {
+                chunk.resize(chunkElements);
+                size_t n = reader.read(chunk.data(), chunkElements);
+                if (n == 0) break;
+                chunk.resize(n);
+                stats.elements += n;
+                
+                DatasetFeatures features = SortingEngine::analyzeDataset(chunk, UNIQUE_SAMPLE);
+                AlgoType algo = SortingEngine::predictBestAlgorithm(features);
+                long long comparisons = 0;
+                SortingEngine::sortWith(algo, chunk, comparisons);
+                stats.runAlgorithms.push_back(algo);
+                
+                string runPath = runPrefix + to_string(runs.size()) + ".tmp";
+                tempFiles.add(runPath);
+                IntFileWriter writer(runPath, 1);
+                runs.push_back(runPath);
+                writer.write(chunk.data(), chunk.size());
+                writer.close();
+            }
+        }
+        auto runsDone = chrono::steady_clock::now();
+        stats.runPhaseMs = chrono::duration<double, milli>(runsDone - start).count();
+        
+        // Phase 2: merge passes until one run remains, the last one into the output
+        size_t memoryElements = max<size_t>(memoryBudgetBytes / sizeof(int), MIN_BUFFER_ELEMENTS);
+        size_t fanIn = min<size_t>(MAX_FAN_IN, max<size_t>(2, memoryElements / MIN_BUFFER_ELEMENTS - 1));
+        int generation = 0;
+        if (runs.empty()) {
+            IntFileWriter(outputPath, 1).close();
+        }
+        while (!runs.empty()) {
+            bool finalPass = runs.size() <= fanIn;
+            vector<string> next;
+            for (size_t first = 0; first < runs.size(); first += fanIn) {
+                size_t last = min(runs.size(), first + fanIn);
+                vector<string> group(runs.begin() + first, runs.begin() + last);
+                string target = finalPass ? outputPath
+                    : runPrefix + "m" + to_string(generation) + "_" + to_string(next.size()) + ".tmp";
+                if (!finalPass) tempFiles.add(target);
+                mergeRuns(group, target, memoryElements);
+                for (const auto& path : group) remove(path.c_str());
+                next.push_back(target);
+            }
+            stats.mergePasses++;
+            generation++;
+            if (finalPass) break;
+            runs = next;
+        }
+        
+        auto end = chrono::steady_clock::now();
+        stats.mergePhaseMs = chrono::duration<double, milli>(end - runsDone).count();
+        stats.totalMs = chrono::duration<double, milli>(end - start).count();
+        double bytes = (double)stats.elements * sizeof(int);
+        stats.throughputMBps = stats.totalMs > 0 ? bytes / 1e6 / (stats.totalMs / 1000.0) : 0.0;
+        return stats;
+    }
+
+private:
+    // Run files written so far; whatever is still on disk is removed when
+    // sortFile returns or throws
+    class TempFiles {
+    public:
+        TempFiles() {}
+        ~TempFiles() {
+            for (const string& path : paths) remove(path.c_str());
+        }
+        void add(const string& path) { paths.push_back(path); }
+
+    private:
+        vector<string> paths;
+
+        TempFiles(const TempFiles&);
+        TempFiles& operator=(const TempFiles&);
+    };
+
+    // Merge sorted run files into `target`, splitting the memory between
+    // one read buffer per run and one write buffer
+    static void mergeRuns(const vector<string>& inputs, const string& target, size_t memoryElements) {
+        size_t bufferElements = max(memoryElements / (inputs.size() + 1), MIN_BUFFER_ELEMENTS);
+        
+        vector<unique_ptr<IntFileReader>> readers;
+        vector<long long> heads;
+        for (const auto& path : inputs) {
+            readers.push_back(unique_ptr<IntFileReader>(new IntFileReader(path, bufferElements)));
+            int value;
+            heads.push_back(readers.back()->next(value) ? value : LoserTree::EXHAUSTED);
+        }
+        
+        IntFileWriter writer(target, bufferElements);
+        ScratchArena::Scope scratch;
+        LoserTree tree(heads.data(), (int)heads.size());
+        while (tree.winnerKey() != LoserTree::EXHAUSTED) {
+            writer.put((int)tree.winnerKey());
+            int value;
+            tree.replaceWinner(readers[tree.winner()]->next(value) ? value : LoserTree::EXHAUSTED);
+        }
+        writer.close();
+    }
+
+    static string baseName(const string& path) {
+        size_t slash = path.find_last_of("/\\");
+        return slash == string::npos ? path : path.substr(slash + 1);
+    }
+};
+
+// max() binds this by reference, so C++11 needs a definition outside the class
+const size_t ExternalSorter::MIN_BUFFER_ELEMENTS;
+
+// ============= Text Ingestion =============
+
+struct TextLoadStats {
+    long long elements = 0;             // Integers parsed
+    long long bytes = 0;                // Text bytes consumed
+    double readMs = 0.0;                // Time spent in fread
+    double parseMs = 0.0;               // Delimiter split + count + parse
+    double parseMBps = 0.0;             // Text bytes / parse time
+};
+
+// Loads comma-, whitespace- or semicolon-separated decimal integers.
+// The file is read in large blocks. Each block is cut at its last delimiter
+// and split into per-thread chunks, again only at delimiters. A count pass
+// sizes the output so the parse pass writes every chunk straight into its
+// slice of the result buffer.
+class TextIntLoader {
+public:
+    static const size_t BLOCK_BYTES = 64 << 20;         // Text read per block
+    static const size_t MIN_CHUNK_BYTES = 1 << 20;      // Smallest per-thread slice
+
+    static vector<int> loadFile(const string& path, TextLoadStats& stats) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) throw runtime_error("Cannot open " + path);
+        
+        vector<int> out;
+        vector<char> block;
+        size_t carry = 0;       // Bytes of a token cut off at the end of the last block
+        try {
+            while (true) {
+                block.resize(carry + BLOCK_BYTES);
+                auto readStart = chrono::steady_clock::now();
+                size_t got = fread(block.data() + carry, 1, BLOCK_BYTES, file);
+                stats.readMs += chrono::duration<double, milli>(chrono::steady_clock::now() - readStart).count();
+                size_t len = carry + got;
+                bool eof = got < BLOCK_BYTES;
+                
+                // Parse up to the last delimiter; the tail waits for the next block
+                size_t cut = len;
+                if (!eof) {
+                    while (cut > 0 && !isDelimiter(block[cut - 1])) cut--;
+                    if (cut == 0) throw runtime_error("Token longer than " + to_string(BLOCK_BYTES) + " bytes");
+                }
+                
+                auto parseStart = chrono::steady_clock::now();
+                parseBlock(block.data(), block.data() + cut, out);
+                stats.parseMs += chrono::duration<double, milli>(chrono::steady_clock::now() - parseStart).count();
+                stats.bytes += cut;
+                
+                carry = len - cut;
+                memmove(block.data(), block.data() + cut, carry);
+                if (eof) break;
+            }
+        } catch (...) {
+            fclose(file);
+            throw;
+        }
+        fclose(file);
+        
+        stats.elements = out.size();
+        stats.parseMBps = stats.parseMs > 0 ? stats.bytes / 1e6 / (stats.parseMs / 1000.0) : 0.0;
+        return out;
+    }
+
+    static bool isDelimiter(char c) {
+        return c == ',' || c == '\n' || c == '\r' || c == ' ' || c == '\t' || c == ';';
+    }
+
+private:
+    // Split [begin, end) into chunks at delimiters, count the tokens of every
+    // chunk, then parse all chunks in parallel into the grown output
+    static void parseBlock(const char* begin, const char* end, vector<int>& out) {
+        size_t bytes = end - begin;
+        int threads = (int)min<size_t>(max(1u, thread::hardware_concurrency()), bytes / MIN_CHUNK_BYTES + 1);
+        
+        vector<const char*> bounds(1, begin);
+        for (int t = 1; t < threads; t++) {
+            const char* p = max(bounds.back(), begin + bytes * t / threads);
+            while (p < end && !isDelimiter(*p)) p++;
+            bounds.push_back(p);
+        }
+        bounds.push_back(end);
+        
+        vector<size_t> offsets(threads + 1, out.size());
+        vector<exception_ptr> errors(threads);
+        runChunks(threads, [&](int t) {
+            offsets[t + 1] = countTokens(bounds[t], bounds[t + 1]);
+        });
+        for (int t = 0; t < threads; t++) offsets[t + 1] += offsets[t];
+        
+        out.resize(offsets[threads]);
+        int* dest = out.data();
+        runChunks(threads, [&](int t) {
+            try {
+                parseChunk(bounds[t], bounds[t + 1], dest + offsets[t]);
+            } catch (...) {
+                errors[t] = current_exception();
+            }
+        });
+        for (const auto& e : errors) {
+            if (e) rethrow_exception(e);
+        }
+    }
+
+    template <typename Body>
+    static void runChunks(int threads, Body body) {
+        vector<thread> pool;
+        for (int t = 1; t < threads; t++) pool.emplace_back(body, t);
+        body(0);
+        for (auto& th : pool) th.join();
+    }
+
+    static size_t countTokens(const char* p, const char* end) {
+        size_t count = 0;
+        bool inToken = false;
+        for (; p < end; p++) {
+            bool delim = isDelimiter(*p);
+            if (!delim && !inToken) count++;
+            inToken = !delim;
+        }
+        return count;
+    }
+
+    // True when all 8 bytes of v are ASCII digits
+    static bool allDigits(uint64_t v) {
+        return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+                (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+    }
+
+    // Value of 8 ASCII digits loaded little-endian (first digit in the low byte)
+    static uint32_t parseEightDigits(uint64_t v) {
+        v -= 0x3030303030303030ULL;
+        v = (v * 10) + (v >> 8);
+        v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+        return (uint32_t)v;
+    }
+
+    static void parseChunk(const char* p, const char* end, int* dest) {
+        while (p < end) {
+            if (isDelimiter(*p)) {
+                p++;
+                continue;
+            }
+            bool negative = (*p == '-');
+            if (negative) p++;
+            
+            const char* digits = p;
+            uint64_t value = 0;
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_WIN32)
+            // Eight digits at a time while the chunk has eight bytes left
+            uint64_t word;
+            if (end - p >= 8 && (memcpy(&word, p, 8), allDigits(word))) {
+                value = parseEightDigits(word);
+                p += 8;
+            }
+#endif
+            while (p < end && (unsigned)(*p - '0') < 10) {
+                // Saturate instead of wrapping so long tokens still fail the range check
+                if (value <= INT_MAX) value = value * 10 + (unsigned)(*p - '0');
+                p++;
+            }
+            if (p == digits || (p < end && !isDelimiter(*p))) {
+                const char* tokenEnd = p;
+                while (tokenEnd < end && !isDelimiter(*tokenEnd) && tokenEnd - digits < 16) tokenEnd++;
+                throw runtime_error("Invalid integer: \"" + string(digits, tokenEnd) + "\"");
+            }
+            if (value > (uint64_t)INT_MAX + (negative ? 1 : 0)) {
+                throw runtime_error("Integer out of range: " + string(negative ? "-" : "") + string(digits, p - digits));
+            }
+            *dest++ = (int)(negative ? -(long long)value : (long long)value);
+        }
+    }
+};
+
+// ============= Main Program =============
+
+// Command-line options that change how the comparison is run
+struct RunOptions {
+    bool parallel = false;           // Run the candidates concurrently on separate cores
+    bool markInterference = false;   // Flag parallel runs that overlapped other runs
+    bool race = false;               // Stop the other candidates once one finishes
+    int topK = 0;                    // Only the k smallest are needed (0 = full sort)
+    const Selector* predictor = nullptr;  // Strategy for full sorts (rules when null)
+    OnlineSelector* selector = nullptr;  // Feed it every measured run
+    string selectorPath;             // Where the selector state is saved after each benchmark
+};
+
+// One dataset of the regret grid: what was predicted, what was fastest
+struct RegretCase {
+    string selector;
+    DatasetType type;
+    int size;
+    uint64_t seed;
+    AlgoType predicted;
+    AlgoType best;
+    double predictedMs;
+    double bestMs;
+    
+    // Time lost to the prediction: predicted time / best time (1.0 = best pick)
+    double regret() const { return predictedMs / max(bestMs, 1e-9); }
+};
+
+void printSeparator(char c = '=', int length = 70) {
+    cout << string(length, c) << endl;
+}
+
+void displayMenu() {
     printSeparator();
     cout << "    AI-Driven Sorting Algorithm Optimizer" << endl;
     printSeparator();
-    cout << "\nSelect Dataset Type:" << endl;
-    cout << "  1. Random Dataset" << endl;
-    cout << "  2. Nearly Sorted Dataset" << endl;
-    cout << "  3. Reversed Dataset" << endl;
-    cout << "  4. Few Unique Values Dataset" << endl;
-    cout << "  5. Large Random Dataset" << endl;
-    cout << "  0. Exit" << endl;
+    cout << "\nSelect Dataset Type:" << endl;
+    for (int t = 0; t < DATASET_TYPE_COUNT; t++) {
+        cout << "  " << setw(2) << right << (t + 1) << ". "
+             << SortingEngine::getDatasetName((DatasetType)t) << " Dataset" << endl;
+    }
+    cout << "   0. Exit" << endl;
+    printSeparator('-', 70);
+}
+
+void displayDataPreview(const vector<int>& data, int maxShow = 40) {
+    cout << "\n[Data Preview]" << endl;
+    cout << "Size: " << data.size() << " elements" << endl;
+    cout << "First " << min(maxShow, (int)data.size()) << " elements: [";
+    for (int i = 0; i < min(maxShow, (int)data.size()); i++) {
+        cout << data[i];
+        if (i < min(maxShow, (int)data.size()) - 1) cout << ", ";
+    }
+    if ((int)data.size() > maxShow) cout << ", ...";
+    cout << "]" << endl;
+}
+
+void displayAnalysis(const DatasetFeatures& features, AlgoType predicted) {
+    cout << "\n[AI Analysis Report]" << endl;
+    printSeparator('-', 70);
+    cout << "Dataset Characteristics:" << endl;
+    cout << "  Type:         " << features.type << endl;
+    cout << "  Size:         " << features.size 
+         << (features.isLargeDataset ? " (Large Dataset)" : " (Small/Medium Dataset)") << endl;
+    cout << "  Sortedness:   " << fixed << setprecision(1) 
+         << (features.sortedness * 100.0) << "%" << endl;
+    cout << "  Reversedness: " << (features.reversedness * 100.0) << "%" << endl;
+    cout << "  Uniqueness:   " << (features.uniqueRatio * 100.0) 
+         << (features.size < HyperLogLog::REGISTERS ? "% (exact)" : "% (HyperLogLog estimate)") << endl;
+    cout << "  Unique Count: " << features.uniqueCount << endl;
+    cout << "  Value Range:  [" << features.minValue << ", " << features.maxValue << "]" << endl;
+    cout << "  Prefix:       " << features.sortedPrefixLength << " elements already in order" << endl;
+    cout << "  Runs:         " << features.runs << " (longest " << features.longestRun << " elements)" << endl;
+    cout << "  Inversions:   " << (features.inversionRatio * 100.0) << "% of pairs (sampled)" << endl;
+    cout << "  Rem:          " << (features.remRatio * 100.0) << "% out of sorted order (sampled)" << endl;
+    cout << "  Entropy:      " << setprecision(2) << features.entropyBits << " bits (sampled), range "
+         << features.rangeBits << " bits" << endl;
+    printSeparator('-', 70);
+    cout << ">>> AI Predicted Best Algorithm: " 
+         << SortingEngine::getAlgoName(predicted) << " <<<" << endl;
+    printSeparator('-', 70);
+}
+
+void displayResults(const vector<SortMetrics>& results, AlgoType actualBest, AlgoType predicted,
+                    bool markInterference = false) {
+    cout << "\n[Sorting Performance Comparison]" << endl;
+    printSeparator('-', 70);
+    cout << left << setw(20) << "Algorithm"
+         << setw(20) << "Comparisons"
+         << setw(20) << "Time (ms)"
+         << setw(10) << "Allocs" << endl;
+    printSeparator('-', 70);
+    
+    for (const auto& res : results) {
+        cout << left << setw(20) << SortingEngine::getAlgoName(res.algo);
+        cout << setw(20) << res.comparisons;
+        cout << setw(20) << fixed << setprecision(4) << res.executionTimeMs;
+        cout << setw(10) << res.heapAllocations;
+        
+        if (res.cancelled) {
+            cout << " (stopped, lost race)";
+        }
+        if (res.algo == actualBest) {
+            cout << " <- FASTEST";
+        }
+        if (res.algo == predicted) {
+            cout << " [AI Predicted]";
+        }
+        if (markInterference && SortingEngine::hasInterference(res)) {
+            cout << " (*)";
+        }
+        cout << endl;
+    }
+    
+    printSeparator('-', 70);
+    if (markInterference) {
+        cout << "(*) Overlapped other runs; time may include memory-bandwidth interference" << endl;
+    }
+    cout << "Actual Best Algorithm: " << SortingEngine::getAlgoName(actualBest) << endl;
+    
+    // Regret: how much slower the predicted algorithm ran than the fastest one
+    double bestMs = 0, predictedMs = -1;
+    for (const auto& res : results) {
+        if (res.algo == actualBest) bestMs = res.executionTimeMs;
+        if (res.algo == predicted && !res.cancelled) predictedMs = res.executionTimeMs;
+    }
+    if (predictedMs >= 0 && bestMs > 0) {
+        cout << "Regret: " << fixed << setprecision(2) << predictedMs / bestMs
+             << "x the best time (" << setprecision(4) << predictedMs - bestMs << " ms lost)" << endl;
+    }
+    
+    if (predicted == actualBest) {
+        cout << "Result: AI Prediction was CORRECT!" << endl;
+    } else {
+        cout << "Result: AI Prediction was INCORRECT." << endl;
+        cout << "  Predicted: " << SortingEngine::getAlgoName(predicted) << endl;
+        cout << "  Actual:    " << SortingEngine::getAlgoName(actualBest) << endl;
+    }
+    printSeparator();
+}
+
+
+// Apply per-type size limits, printing a note when the size is changed (unless quiet)
+int adjustDatasetSize(DatasetType type, int size, bool quiet = false) {
+    if (type == LARGE_RANDOM_DATA && size < 10000) {
+        if (!quiet) cout << "Note: Large Random Dataset requires minimum size of 10000. Adjusting size to 10000." << endl;
+        return 10000;
+    }
+    if (type == QUICKSORT_KILLER_DATA && size > 20000) {
+        if (!quiet) cout << "Note: Quick Sort Killer generation is O(n^2). Limiting size to 20000." << endl;
+        return 20000;
+    }
+    return size;
+}
+
+// Clamp the type-specific parameter (unique count or run count) to its range
+int clampDatasetParam(DatasetType type, int param) {
+    if (type == FEW_UNIQUE_DATA) return max(2, min(param, 50));
+    if (type == SAWTOOTH_DATA) return max(2, min(param, 1000));
+    return param;
+}
+
+// Run the AI analysis and the sorting comparison on one dataset
+void runBenchmark(const vector<int>& dataset, const RunOptions& options) {
+    int size = (int)dataset.size();
+    
+    // Display preview
+    displayDataPreview(dataset);
+    
+    // AI Analysis
+    cout << "\nPerforming AI analysis..." << endl;
+    long long allocationsBefore = heapAllocations();
+    DatasetFeatures features = SortingEngine::analyzeDataset(dataset);
+    bool topK = options.topK > 0 && options.topK < size;
+    int k = topK ? options.topK : -1;
+    const ProbeSelector* probing = dynamic_cast<const ProbeSelector*>(options.predictor);
+    ProbeSelector::Probe probe;
+    AlgoType predicted = topK ? SortingEngine::predictTopKAlgorithm(features, k)
+                              : probing ? probing->run(dataset, features, probe)
+                              : options.predictor ? options.predictor->predictOn(dataset, features)
+                              : SortingEngine::predictBestAlgorithm(features);
+    long long analysisAllocations = heapAllocations() - allocationsBefore;
+    displayAnalysis(features, predicted);
+    cout << "Analysis and prediction made " << analysisAllocations << " heap allocations" << endl;
+    if (probe.sampleSize > 0) {
+        cout << "Probe: " << probe.sampleSize << "-element sample in " << fixed << setprecision(4)
+             << probe.probeMs << " ms, extrapolated full sort:";
+        for (const auto& candidate : probe.extrapolated) {
+            cout << " " << SortingEngine::getAlgoName(candidate.first) << " " << setprecision(2) << candidate.second << " ms;";
+        }
+        cout << endl;
+    }
+    
+    // Run sorting algorithms
+    cout << "\nRunning sorting algorithms..." << endl;
+    vector<AlgoType> algorithms;
+    
+    if (topK) {
+        // The selection kernels, with the full sorts as the baseline they replace
+        cout << "  (Top-k mode: only the " << k << " smallest elements are sorted)" << endl;
+        algorithms.push_back(HEAP_SELECT);
+        algorithms.push_back(INTRO_SELECT);
+        algorithms.push_back(RADIX_SELECT);
+    } else if (size <= 1000 || options.race) {
+        // Skip O(n^2) algorithms for large datasets to save time.
+        // A race stops them as soon as a faster algorithm wins, so it keeps them at any size.
+        algorithms.push_back(BUBBLE_SORT);
+        algorithms.push_back(INSERTION_SORT);
+    } else {
+        cout << "  (Skipping O(n²) algorithms for large dataset)" << endl;
+    }
+    algorithms.push_back(MERGE_SORT);
+    algorithms.push_back(BLOCKED_MERGE_SORT);
+    // Lomuto quick sort is O(n^2) on runs of equal keys (about n / uniqueCount
+    // per key), so large inputs with few unique keys skip it as well
+    if (size <= 1000 || options.race || features.uniqueCount * 64LL >= size) {
+        algorithms.push_back(QUICK_SORT);
+    } else {
+        cout << "  (Skipping Quick Sort: too few unique keys for Lomuto partitioning)" << endl;
+    }
+    if (!topK) {
+        algorithms.push_back(BLOCK_QUICK_SORT);
+        algorithms.push_back(VECTOR_QUICK_SORT);
+        algorithms.push_back(BRANCHLESS_MERGE_SORT);
+        algorithms.push_back(RADIX_SORT);
+        algorithms.push_back(PREFIX_MERGE);
+        algorithms.push_back(RUN_MERGE_SORT);
+        algorithms.push_back(COUNTING_SORT);
+    }
+    
+    vector<SortMetrics> results;
+    auto wallStart = chrono::steady_clock::now();
+    auto report = [](const SortMetrics& m) {
+        cout << "  " << (m.cancelled ? "Stopped " : "Finished ") << SortingEngine::getAlgoName(m.algo);
+        if (m.core >= 0) cout << " on core " << m.core;
+        cout << " (" << fixed << setprecision(4) << m.executionTimeMs << " ms)" << endl;
+    };
+    if (options.race) {
+        cout << "  Racing " << algorithms.size() << " algorithms..." << endl;
+        results = SortingEngine::runRace(algorithms, dataset, report, nullptr, k);
+    } else if (options.parallel) {
+        cout << "  Running " << algorithms.size() << " algorithms in parallel..." << endl;
+        results = SortingEngine::runParallelComparison(algorithms, dataset, report, nullptr, k);
+    } else {
+        for (AlgoType algo : algorithms) {
+            cout << "  Running " << SortingEngine::getAlgoName(algo) << "..." << endl;
+            results.push_back(SortingEngine::runSort(algo, dataset, nullptr, nullptr, k));
+        }
+    }
+    double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - wallStart).count();
+    cout << "  Comparison wall time: " << fixed << setprecision(4) << wallMs << " ms" << endl;
+    
+    // Find the fastest algorithm among the runs that finished
+    AlgoType actualBest = ALGO_TYPE_COUNT;
+    double minTime = 1e9;
+    for (const auto& r : results) {
+        if (!r.cancelled && r.executionTimeMs < minTime) {
+            minTime = r.executionTimeMs;
+            actualBest = r.algo;
+        }
+    }
+    
+    // Display results
+    displayResults(results, actualBest, predicted,
+                   (options.parallel || options.race) && options.markInterference);
+    
+    // Every full sort that ran to completion is feedback for the online selector
+    if (options.selector && !topK) {
+        for (const SortMetrics& r : results) {
+            if (!r.cancelled) options.selector->record(features, r.algo, r.executionTimeMs);
+        }
+        options.selector->save(options.selectorPath);
+        cout << "Online selector now picks " << SortingEngine::getAlgoName(options.selector->best(features))
+             << " for this kind of input (state saved to " << options.selectorPath << ")" << endl;
+    }
+}
+
+// Generate one dataset and benchmark it
+void runSession(DatasetType type, int size, int param, uint64_t seed, const RunOptions& options) {
+    size = adjustDatasetSize(type, size);
+    SortingEngine::pivotSeed() = seed;
+    
+    cout << "\nGenerating " << SortingEngine::getDatasetName(type)
+         << " dataset (seed " << seed << ")..." << endl;
+    runBenchmark(SortingEngine::generateDataset(type, size, param, seed), options);
+}
+
+// Generate one dataset straight into a new memory-mapped file
+int saveDataset(DatasetType type, int size, int param, uint64_t seed, const string& path) {
+    size = adjustDatasetSize(type, size);
+    cout << "Generating " << SortingEngine::getDatasetName(type)
+         << " dataset (seed " << seed << ")..." << endl;
+    try {
+        vector<int> dataset = SortingEngine::generateDataset(type, size, param, seed);
+        MappedIntFile file(path, MappedIntFile::CREATE, dataset.size());
+        if (!dataset.empty()) memcpy(file.data(), dataset.data(), dataset.size() * sizeof(int));
+        file.sync();
+    } catch (const exception& e) {
+        cout << "\nError: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Saved " << size << " elements to " << path << endl;
+    return 0;
+}
+
+// Benchmark a dataset previously written with --save
+int runLoadedBenchmark(const string& path, uint64_t seed, const RunOptions& options) {
+    SortingEngine::pivotSeed() = seed;
+    try {
+        MappedIntFile file(path, MappedIntFile::READ_ONLY);
+        if (file.size() < 2) throw runtime_error(path + " holds fewer than 2 elements");
+        file.advise(MappedIntFile::ADVISE_SEQUENTIAL);
+        cout << "\nLoaded " << file.size() << " elements from " << path << endl;
+        // Every candidate sorts its own copy, so the mapping is only read once
+        runBenchmark(vector<int>(file.data(), file.data() + file.size()), options);
+    } catch (const exception& e) {
+        cout << "\nError: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Append-and-resort stream: sort one dataset, then repeatedly append 1% new
+// values and re-sort with the algorithm chosen from the tracked features,
+// timing a full quick sort of the same buffer for comparison
+int runAppendStream(DatasetType type, int size, int param, uint64_t seed, int batches) {
+    size = adjustDatasetSize(type, size);
+    SortingEngine::pivotSeed() = seed;
+    SortingEngine::pivotRng() = Rng(seed);
+    FeatureTracker tracker(SortingEngine::generateDataset(type, size, param, seed));
+    
+    long long comparisons = 0;
+    AlgoType first = SortingEngine::predictBestAlgorithm(tracker.features());
+    SortingEngine::sortWith(first, tracker.mutableData(), comparisons);
+    tracker.markSorted();
+    
+    int batchSize = max(1, size / 100);
+    cout << "\nSorted " << size << " elements with " << SortingEngine::getAlgoName(first)
+         << "; appending " << batches << " batches of " << batchSize << endl;
+    printSeparator('-', 70);
+    cout << left << setw(8) << "Batch" << setw(12) << "Size" << setw(16) << "Predicted"
+         << setw(14) << "Time (ms)" << setw(14) << "Quick (ms)" << "Speedup" << endl;
+    printSeparator('-', 70);
+    
+    Rng values(seed, 1);
+    uint32_t range = (uint32_t)min(10LL * size, (long long)INT32_MAX - 1);
+    for (int b = 1; b <= batches; b++) {
+        for (int i = 0; i < batchSize; i++) tracker.push_back(1 + (int)values.below(range));
+        
+        SortMetrics full = SortingEngine::runSort(QUICK_SORT, tracker.data());
+        
+        auto start = chrono::high_resolution_clock::now();
+        AlgoType algo = SortingEngine::predictBestAlgorithm(tracker.features());
+        comparisons = 0;
+        SortingEngine::sortWith(algo, tracker.mutableData(), comparisons);
+        tracker.markSorted();
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        
+        cout << left << setw(8) << b << setw(12) << tracker.size()
+             << setw(16) << SortingEngine::getAlgoName(algo)
+             << fixed << setprecision(4) << setw(14) << ms << setw(14) << full.executionTimeMs
+             << setprecision(1) << (full.executionTimeMs / max(ms, 1e-6)) << "x" << endl;
+    }
+    printSeparator();
+    return 0;
+}
+
+// Sort records of one int key and a `payloadWidth`-byte payload with each
+// algorithm (argsort plus one gather), then with the payload packed next to
+// the key when it fits; payloadWidth 0 times the argsort alone
+int runRecordSort(DatasetType type, int size, int param, uint64_t seed, int payloadWidth) {
+    size = adjustDatasetSize(type, size);
+    SortingEngine::pivotSeed() = seed;
+    RecordTable table;
+    table.keys = SortingEngine::generateDataset(type, size, param, seed);
+    if (payloadWidth > 0) {
+        // Payload bytes are the record's input position, so the gather can be checked
+        table.widths.push_back(payloadWidth);
+        table.columns.push_back(vector<unsigned char>((size_t)size * payloadWidth));
+        for (int i = 0; i < size; i++) {
+            for (int b = 0; b < payloadWidth; b++) {
+                table.columns[0][(size_t)i * payloadWidth + b] = (unsigned char)(i >> (8 * (b % 4)));
+            }
+        }
+    }
+    
+    // Every plan must leave the input positions ordered by key and ascending
+    // within equal keys; output record i then carries position order[i]
+    vector<int> order(size);
+    for (int i = 0; i < size; i++) order[i] = i;
+    stable_sort(order.begin(), order.end(), [&table](int a, int b) { return table.keys[a] < table.keys[b]; });
+    
+    DatasetFeatures features = SortingEngine::analyzeDataset(table.keys);
+    RecordPlan predicted = SortingEngine::predictRecordPlan(features, table.payloadBytes());
+    cout << "\nSorting " << size << " records with a " << payloadWidth << "-byte payload" << endl;
+    cout << "Predicted plan: " << SortingEngine::getAlgoName(predicted.algo)
+         << (predicted.inlinePayload ? " (payload packed with the key)" : " (argsort + gather)") << endl;
+    printSeparator('-', 70);
+    cout << left << setw(28) << "Plan" << setw(16) << "Time (ms)" << "Comparisons" << endl;
+    printSeparator('-', 70);
+    
+    vector<RecordPlan> plans;
+    if (size <= 1000) {
+        RecordPlan insertion = {INSERTION_SORT, false};
+        plans.push_back(insertion);
+    }
+    AlgoType full[] = {MERGE_SORT, BLOCKED_MERGE_SORT, QUICK_SORT, BLOCK_QUICK_SORT, VECTOR_QUICK_SORT, RADIX_SORT};
+    for (AlgoType algo : full) {
+        RecordPlan plan = {algo, false};
+        plans.push_back(plan);
+    }
+    if (payloadWidth <= 4) {
+        RecordPlan packed = {RADIX_SORT, true};
+        plans.push_back(packed);
+    }
+    
+    string best;
+    double bestMs = 0;
+    for (const RecordPlan& plan : plans) {
+        RecordTable copy = table;
+        long long comparisons = 0;
+        auto start = chrono::high_resolution_clock::now();
+        SortingEngine::sortRecords(copy, plan, comparisons);
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        
+        // Keys in order, and each payload decodes to the position it was
+        // gathered from (its low bytes when narrower than an int)
+        for (int i = 0; i < size; i++) {
+            if (i > 0 && copy.keys[i] < copy.keys[i - 1]) throw runtime_error("Record sort left keys out of order");
+            for (int b = 0; b < payloadWidth; b++) {
+                if (copy.columns[0][(size_t)i * payloadWidth + b] != (unsigned char)(order[i] >> (8 * (b % 4)))) {
+                    throw runtime_error("Record sort gathered a payload from the wrong record");
+                }
+            }
+        }
+        string name = SortingEngine::getAlgoName(plan.algo) + (plan.inlinePayload ? " (packed)" : " (gather)");
+        cout << left << setw(28) << name << fixed << setprecision(4) << setw(16) << ms << comparisons << endl;
+        if (best.empty() || ms < bestMs) {
+            best = name;
+            bestMs = ms;
+        }
+    }
     printSeparator('-', 70);
+    cout << "Fastest: " << best << endl;
+    printSeparator();
+    return 0;
 }
 
-void displayDataPreview(const vector<int>& data, int maxShow = 40) {
-    cout << "\n[Data Preview]" << endl;
-    cout << "Size: " << data.size() << " elements" << endl;
-    cout << "First " << min(maxShow, (int)data.size()) << " elements: [";
-    for (int i = 0; i < min(maxShow, (int)data.size()); i++) {
-        cout << data[i];
-        if (i < min(maxShow, (int)data.size()) - 1) cout << ", ";
+// Branch-miss comparison on random data: each branchy kernel next to its
+// branchless variant, with the misses counted by the CPU (perf_event_open)
+// and shown as "n/a" where the counter cannot be opened
+int runBranchBenchmark(int size, uint64_t seed) {
+    vector<int> data = SortingEngine::generateRandomDataset(size, seed);
+    PerfCounter misses = PerfCounter::branchMisses();
+    
+    cout << "\nBranch misses sorting " << size << " random elements" << endl;
+    if (!misses.available()) cout << "(hardware counters unavailable: misses shown as n/a)" << endl;
+    cout << "Vector partition: " << (SortingEngine::hasAvx512() ? "AVX-512" : SortingEngine::hasAvx2() ? "AVX2" : "scalar fallback") << endl;
+    printSeparator('-', 70);
+    cout << left << setw(20) << "Algorithm" << setw(14) << "Time (ms)" << setw(16) << "Comparisons"
+         << setw(14) << "Misses" << "Misses/elem" << endl;
+    printSeparator('-', 70);
+    
+    AlgoType kernels[] = {QUICK_SORT, BLOCK_QUICK_SORT, VECTOR_QUICK_SORT, MERGE_SORT, BRANCHLESS_MERGE_SORT};
+    for (AlgoType algo : kernels) {
+        SortingEngine::pivotRng() = Rng(seed);
+        vector<int> copy = data;
+        long long comparisons = 0;
+        misses.start();
+        auto start = chrono::high_resolution_clock::now();
+        SortingEngine::sortWith(algo, copy, comparisons);
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        long long count = misses.read();
+        
+        cout << left << setw(20) << SortingEngine::getAlgoName(algo) << fixed << setprecision(3)
+             << setw(14) << ms << setw(16) << comparisons;
+        if (count >= 0) {
+            cout << setw(14) << count << setprecision(3) << (double)count / size << endl;
+        } else {
+            cout << setw(14) << "n/a" << "n/a" << endl;
+        }
     }
-    if ((int)data.size() > maxShow) cout << ", ...";
-    cout << "]" << endl;
+    printSeparator();
+    return 0;
 }
 
-void displayAnalysis(const DatasetFeatures& features, AlgoType predicted) {
-    cout << "\n[AI Analysis Report]" << endl;
+// NUMA comparison: one thread with the predicted algorithm, then the parallel
+// sample sort with NUMA-oblivious placement and with node-local placement.
+// `simulatedNodes` > 0 splits the cores into pretend nodes instead of detecting them.
+int runNumaSort(DatasetType type, int size, int param, uint64_t seed, int simulatedNodes) {
+    size = adjustDatasetSize(type, size);
+    SortingEngine::pivotSeed() = seed;
+    vector<int> data = SortingEngine::generateDataset(type, size, param, seed);
+    NumaTopology topology = simulatedNodes > 0 ? NumaSorter::simulate(simulatedNodes) : NumaSorter::detect();
+    
+    cout << "\nNUMA-aware sort of " << size << " elements (" << SortingEngine::getDatasetName(type) << ")" << endl;
+    cout << "Topology: " << topology.nodes() << " node(s), " << topology.cores() << " core(s) from " << topology.source << endl;
+    for (int node = 0; node < topology.nodes(); node++) {
+        cout << "  node " << topology.nodeIds[node] << ": cores";
+        for (int core : topology.nodeCores[node]) cout << " " << core;
+        cout << endl;
+    }
+    
+    vector<int> reference = data;
+    AlgoType algo = SortingEngine::predictBestAlgorithm(SortingEngine::analyzeDataset(reference));
+    long long comparisons = 0;
+    auto start = chrono::steady_clock::now();
+    SortingEngine::sortWith(algo, reference, comparisons);
+    double singleMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
     printSeparator('-', 70);
-    cout << "Dataset Characteristics:" << endl;
-    cout << "  Type:         " << features.type << endl;
-    cout << "  Size:         " << features.size 
-         << (features.isLargeDataset ? " (Large Dataset)" : " (Small/Medium Dataset)") << endl;
-    cout << "  Sortedness:   " << fixed << setprecision(1) 
-         << (features.sortedness * 100.0) << "%" << endl;
-    cout << "  Reversedness: " << (features.reversedness * 100.0) << "%" << endl;
-    cout << "  Uniqueness:   " << (features.uniqueRatio * 100.0) 
-         << "% (from sample)" << endl;
-    cout << "  Unique Count: " << features.uniqueCount << endl;
+    cout << left << setw(22) << "Mode" << setw(10) << "Total" << setw(10) << "Count" << setw(10) << "Touch"
+         << setw(10) << "Scatter" << "Sort (ms)" << endl;
     printSeparator('-', 70);
-    cout << ">>> AI Predicted Best Algorithm: " 
-         << SortingEngine::getAlgoName(predicted) << " <<<" << endl;
+    cout << left << setw(22) << "1 thread" << fixed << setprecision(2) << setw(10) << singleMs
+         << "(" << SortingEngine::getAlgoName(algo) << ")" << endl;
+    
+    bool boundByLibnuma = false;
+    vector<long long> nodeElements;
+    for (int aware = 0; aware < 2; aware++) {
+        // Oblivious: the input is written by this thread; aware: by the worker that reads it
+        NodeMemory input((size_t)size, -1);
+        if (aware) NumaSorter::placeInput(data.data(), size, topology, input);
+        else copy(data.begin(), data.end(), input.data());
+        NumaSortStats stats = NumaSorter::sort(input.data(), size, topology, aware != 0);
+        if (!equal(reference.begin(), reference.end(), input.data())) {
+            throw runtime_error("NUMA sort result differs from the single-thread sort");
+        }
+        string mode = string(aware ? "Node-aware" : "Oblivious") + " x" + to_string(stats.workers);
+        cout << left << setw(22) << mode << fixed << setprecision(2) << setw(10) << stats.totalMs
+             << setw(10) << stats.countMs << setw(10) << stats.touchMs << setw(10) << stats.scatterMs
+             << stats.sortMs << "  (" << setprecision(2) << singleMs / max(stats.totalMs, 1e-9) << "x)" << endl;
+        if (aware) {
+            boundByLibnuma = stats.boundByLibnuma;
+            nodeElements = stats.nodeElements;
+        }
+    }
     printSeparator('-', 70);
+    cout << "Placement: " << (boundByLibnuma ? "bound with libnuma" : "first touch") << "; elements sorted per node:";
+    for (long long count : nodeElements) cout << " " << count;
+    cout << endl;
+    printSeparator();
+    return 0;
 }
 
-void displayResults(const vector<SortMetrics>& results, const string& actualBest, const string& predicted) {
-    cout << "\n[Sorting Performance Comparison]" << endl;
+// Tiny-batch workload: `count` arrays of 16-64 random elements stored back to
+// back, sorted one by one with insertion sort, std::sort and the batch engine
+int runTinyBatch(int count, uint64_t seed) {
+    Rng rng(seed);
+    vector<int> lengths(count);
+    size_t total = 0;
+    for (int& length : lengths) {
+        length = 16 + (int)rng.below(49);
+        total += length;
+    }
+    vector<int> data(total);
+    for (int& value : data) value = (int)(rng.next() >> 32);
+    
+    cout << "\nSorting " << count << " arrays of 16-64 elements (" << total << " elements)" << endl;
+    cout << "Sorting network: " << (SortingEngine::hasAvx2() ? "AVX2" : "unavailable (insertion sort leaves)") << endl;
     printSeparator('-', 70);
-    cout << left << setw(20) << "Algorithm"
-         << setw(20) << "Comparisons"
-         << setw(20) << "Time (ms)" << endl;
+    cout << left << setw(20) << "Engine" << setw(16) << "Time (ms)" << "Arrays/s" << endl;
     printSeparator('-', 70);
     
-    for (const auto& res : results) {
-        cout << left << setw(20) << res.algoName;
-        cout << setw(20) << res.comparisons;
-        cout << setw(20) << fixed << setprecision(4) << res.executionTimeMs;
-        
-        if (res.algoName == actualBest) {
-            cout << " <- FASTEST";
+    const char* engines[] = {"Insertion Sort", "std::sort", "Tiny Batch"};
+    for (int e = 0; e < 3; e++) {
+        vector<int> copy = data;
+        long long comparisons = 0;
+        auto start = chrono::high_resolution_clock::now();
+        if (e == 2) {
+            SortingEngine::sortTinyBatch(copy.data(), lengths.data(), count, comparisons);
+        } else {
+            int* array = copy.data();
+            for (int length : lengths) {
+                if (e == 0) SortingEngine::insertionSort(array, length, comparisons);
+                else sort(array, array + length);
+                array += length;
+            }
         }
-        if (res.algoName == predicted) {
-            cout << " [AI Predicted]";
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        
+        const int* array = copy.data();
+        for (int length : lengths) {
+            if (!is_sorted(array, array + length)) throw runtime_error(string(engines[e]) + " left an array unsorted");
+            array += length;
         }
-        cout << endl;
+        cout << left << setw(20) << engines[e] << fixed << setprecision(2) << setw(16) << ms
+             << setprecision(0) << count / (ms / 1000.0) << endl;
     }
+    printSeparator();
+    return 0;
+}
+
+// Simulated live traffic for the online selector: `rounds` datasets of one
+// type (a new seed each), each sorted once with the engine the selector
+// chooses and fed back into it. Rounds are spread over one thread per core,
+// all sharing the selector. Prints the choices per tenth of the run.
+int runOnlineTraffic(DatasetType type, int size, int param, uint64_t seed, int rounds,
+                     OnlineSelector& selector, const string& statePath) {
+    size = adjustDatasetSize(type, size);
+    struct Round {
+        AlgoType algo;
+        double ms;
+        bool explored;
+    };
+    vector<Round> log(rounds);
+    atomic<int> next(0);
+    
+    auto worker = [&]() {
+        for (int r = next.fetch_add(1); r < rounds; r = next.fetch_add(1)) {
+            vector<int> data = SortingEngine::generateDataset(type, size, param, seed + r);
+            DatasetFeatures features = SortingEngine::analyzeDataset(data, 1 << 16);
+            bool explored = false;
+            AlgoType algo = selector.choose(features, &explored);
+            SortMetrics m = SortingEngine::runSort(algo, data);
+            selector.record(features, algo, m.executionTimeMs);
+            log[r].algo = algo;
+            log[r].ms = m.executionTimeMs;
+            log[r].explored = explored;
+        }
+    };
+    int threads = max(1, min((int)thread::hardware_concurrency(), rounds));
+    cout << "\nOnline selection: " << rounds << " rounds of " << size << " "
+         << SortingEngine::getDatasetName(type) << " elements on " << threads << " thread(s)" << endl;
+    vector<thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (auto& th : pool) th.join();
     
     printSeparator('-', 70);
-    cout << "Actual Best Algorithm: " << actualBest << endl;
+    cout << left << setw(14) << "Rounds" << setw(22) << "Most chosen" << setw(12) << "Explored"
+         << "Mean time (ms)" << endl;
+    printSeparator('-', 70);
+    int windows = min(10, rounds);
+    for (int w = 0; w < windows; w++) {
+        int from = rounds * w / windows, to = rounds * (w + 1) / windows;
+        int chosen[ALGO_TYPE_COUNT] = {};
+        int explored = 0;
+        double totalMs = 0;
+        for (int r = from; r < to; r++) {
+            chosen[log[r].algo]++;
+            explored += log[r].explored;
+            totalMs += log[r].ms;
+        }
+        int top = (int)(max_element(chosen, chosen + ALGO_TYPE_COUNT) - chosen);
+        cout << left << setw(14) << (to_string(from + 1) + "-" + to_string(to))
+             << setw(22) << SortingEngine::getAlgoName((AlgoType)top) << setw(12) << explored
+             << fixed << setprecision(4) << totalMs / max(1, to - from) << endl;
+    }
+    printSeparator();
+    selector.save(statePath);
+    cout << "Selector state saved to " << statePath << endl;
+    return 0;
+}
+
+// Print one summary row of the regret grid
+void printRegretRow(const string& label, const vector<RegretCase>& cases) {
+    if (cases.empty()) return;
+    int correct = 0, within = 0;
+    double sum = 0, logSum = 0;
+    const RegretCase* worst = &cases[0];
+    for (const RegretCase& c : cases) {
+        double regret = c.regret();
+        correct += (c.predicted == c.best);
+        within += (regret <= 1.10);
+        sum += regret;
+        logSum += log(regret);
+        if (regret > worst->regret()) worst = &c;
+    }
+    int n = (int)cases.size();
+    ostringstream worstText;
+    worstText << fixed << setprecision(2) << worst->regret() << "x "
+              << SortingEngine::getAlgoName(worst->predicted) << " @" << worst->size;
+    cout << left << setw(26) << label << setw(7) << n << fixed << setprecision(0)
+         << setw(10) << 100.0 * correct / n << setw(10) << 100.0 * within / n << setprecision(3)
+         << setw(9) << sum / n << setw(9) << exp(logSum / n) << worstText.str() << endl;
+}
+
+// Prediction quality over every dataset type x size x seed. Each dataset is
+// sorted by every safe candidate plus each selector's pick (best of a few
+// repetitions for small inputs), and every selector is scored by regret,
+// predicted time / best time, rather than by exact label match. Summaries
+// by type and by size go to stdout, one row per dataset and selector to
+// csvPath. With several selectors an A/B table compares them on the same
+// measurements, including the throughput their picks would have delivered
+// and the time predict() itself takes on the grid's features.
+int runRegretGrid(const vector<int>& sizes, int seeds, uint64_t seed, const string& csvPath,
+                  const vector<const Selector*>& selectors) {
+    cout << "\nRegret grid: " << DATASET_TYPE_COUNT << " dataset types x " << sizes.size()
+         << " sizes x " << seeds << " seed(s), selector(s):";
+    for (const Selector* selector : selectors) cout << " " << selector->name();
+    cout << endl;
+    vector<vector<RegretCase> > cases(selectors.size());
+    vector<DatasetFeatures> caseFeatures;
+    for (int t = 0; t < DATASET_TYPE_COUNT; t++) {
+        DatasetType type = (DatasetType)t;
+        vector<int> typeSizes;
+        for (int requested : sizes) {
+            // Size limits can map several requested sizes to one; run it once
+            int size = adjustDatasetSize(type, requested, true);
+            if (find(typeSizes.begin(), typeSizes.end(), size) != typeSizes.end()) continue;
+            typeSizes.push_back(size);
+            for (int s = 0; s < seeds; s++) {
+                uint64_t caseSeed = seed + s;
+                vector<int> data = SortingEngine::generateDataset(type, size, type == SAWTOOTH_DATA ? 8 : 5, caseSeed);
+                DatasetFeatures features = SortingEngine::analyzeDataset(data);
+                caseFeatures.push_back(features);
+                vector<AlgoType> picks;
+                vector<double> overheadMs(selectors.size(), 0);
+                for (size_t i = 0; i < selectors.size(); i++) {
+                    picks.push_back(selectors[i]->predictOn(data, features, &overheadMs[i]));
+                }
+                
+                // Quadratic candidates only where they finish quickly, unless predicted
+                vector<double> ms(ALGO_TYPE_COUNT, -1);
+                int reps = max(1, min(25, 200000 / max(size, 1)));
+                AlgoType best = RADIX_SORT;
+                for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+                    AlgoType algo = (AlgoType)a;
+                    if (algo == HEAP_SELECT || algo == INTRO_SELECT || algo == RADIX_SELECT) continue;
+                    bool quadratic = (algo == BUBBLE_SORT || algo == INSERTION_SORT) ? size > 1000
+                                   : (algo == QUICK_SORT) ? size > 10000 : false;
+                    if (quadratic && find(picks.begin(), picks.end(), algo) == picks.end()) continue;
+                    
+                    ms[a] = 1e18;
+                    for (int r = 0; r < reps; r++) {
+                        SortingEngine::pivotSeed() = caseSeed;
+                        ms[a] = min(ms[a], SortingEngine::runSort(algo, data).executionTimeMs);
+                    }
+                    if (ms[best] < 0 || ms[a] < ms[best]) best = algo;
+                }
+                
+                for (size_t i = 0; i < selectors.size(); i++) {
+                    RegretCase c;
+                    c.selector = selectors[i]->name();
+                    c.type = type;
+                    c.size = size;
+                    c.seed = caseSeed;
+                    c.predicted = picks[i];
+                    c.best = best;
+                    c.predictedMs = ms[picks[i]] + overheadMs[i];   // A probe counts against its pick
+                    c.bestMs = ms[best];
+                    cases[i].push_back(c);
+                }
+            }
+        }
+        cout << "  " << SortingEngine::getDatasetName(type) << " done" << endl;
+    }
     
-    if (predicted == actualBest) {
-        cout << "Result: AI Prediction was CORRECT!" << endl;
-    } else {
-        cout << "Result: AI Prediction was INCORRECT." << endl;
-        cout << "  Predicted: " << predicted << endl;
-        cout << "  Actual:    " << actualBest << endl;
+    vector<int> bucketSizes;
+    for (const RegretCase& c : cases[0]) {
+        if (find(bucketSizes.begin(), bucketSizes.end(), c.size) == bucketSizes.end()) bucketSizes.push_back(c.size);
+    }
+    sort(bucketSizes.begin(), bucketSizes.end());
+    
+    for (size_t i = 0; i < selectors.size(); i++) {
+        printSeparator('-', 86);
+        cout << left << setw(26) << "Selector: " + selectors[i]->name() << setw(7) << "Cases" << setw(10) << "Exact %"
+             << setw(10) << "<=1.1x %" << setw(9) << "Mean" << setw(9) << "GeoMean" << "Worst regret" << endl;
+        printSeparator('-', 86);
+        for (int t = 0; t < DATASET_TYPE_COUNT; t++) {
+            vector<RegretCase> group;
+            for (const RegretCase& c : cases[i]) if (c.type == t) group.push_back(c);
+            printRegretRow(SortingEngine::getDatasetName((DatasetType)t), group);
+        }
+        printSeparator('-', 86);
+        for (int size : bucketSizes) {
+            vector<RegretCase> group;
+            for (const RegretCase& c : cases[i]) if (c.size == size) group.push_back(c);
+            printRegretRow("n = " + to_string(size), group);
+        }
+        printSeparator('-', 86);
+        printRegretRow("All", cases[i]);
+    }
+    printSeparator('=', 86);
+    
+    // A/B: the same datasets sorted by each selector's picks
+    if (selectors.size() > 1) {
+        cout << left << setw(26) << "A/B" << setw(7) << "Cases" << setw(10) << "Exact %" << setw(10) << "<=1.1x %"
+             << setw(9) << "Mean" << setw(9) << "GeoMean" << "Worst regret" << endl;
+        printSeparator('-', 86);
+        for (size_t i = 0; i < selectors.size(); i++) printRegretRow(selectors[i]->name(), cases[i]);
+        printSeparator('-', 86);
+        int rounds = max(1, 200000 / (int)caseFeatures.size());
+        for (size_t i = 0; i < selectors.size(); i++) {
+            double elements = 0, predictedMs = 0, bestMs = 0;
+            for (const RegretCase& c : cases[i]) {
+                elements += c.size;
+                predictedMs += c.predictedMs;
+                bestMs += c.bestMs;
+            }
+            
+            // Prediction latency alone: the sort time above hides it
+            volatile int sink = 0;
+            auto start = chrono::steady_clock::now();
+            for (int r = 0; r < rounds; r++) {
+                for (const DatasetFeatures& f : caseFeatures) sink = sink + selectors[i]->predict(f);
+            }
+            double predictNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count()
+                             / ((double)rounds * caseFeatures.size());
+            
+            cout << left << setw(26) << selectors[i]->name() << fixed << setprecision(1)
+                 << elements / predictedMs / 1000 << " M elements/s (oracle " << elements / bestMs / 1000
+                 << "), predict " << predictNs << " ns" << endl;
+        }
+        printSeparator('=', 86);
+    }
+    
+    if (!csvPath.empty()) {
+        FILE* csv = fopen(csvPath.c_str(), "w");
+        if (!csv) {
+            cout << "Error: cannot write " << csvPath << endl;
+            return 1;
+        }
+        fprintf(csv, "selector,dataset,size,seed,predicted,best,predicted_ms,best_ms,regret\n");
+        size_t rows = 0;
+        for (const vector<RegretCase>& selectorCases : cases) {
+            for (const RegretCase& c : selectorCases) {
+                fprintf(csv, "%s,%s,%d,%llu,%s,%s,%.6f,%.6f,%.4f\n", c.selector.c_str(),
+                        SortingEngine::getDatasetFlag(c.type).c_str(), c.size, (unsigned long long)c.seed,
+                        SortingEngine::getAlgoName(c.predicted).c_str(), SortingEngine::getAlgoName(c.best).c_str(),
+                        c.predictedMs, c.bestMs, c.regret());
+                rows++;
+            }
+        }
+        fclose(csv);
+        cout << "Wrote " << rows << " rows to " << csvPath << endl;
+    }
+    return 0;
+}
+
+// Parse a text file of integers, then analyze it and sort it with the predicted
+// algorithm, reporting parse and sort throughput separately
+int runTextSort(const string& path) {
+    printSeparator();
+    cout << "    Text Ingestion and Sort" << endl;
+    printSeparator();
+    cout << "File:          " << path << endl;
+    try {
+        TextLoadStats load;
+        vector<int> data = TextIntLoader::loadFile(path, load);
+        cout << "Elements:      " << load.elements << endl;
+        if (data.size() < 2) throw runtime_error(path + " holds fewer than 2 integers");
+        
+        auto start = chrono::steady_clock::now();
+        DatasetFeatures features = SortingEngine::analyzeDataset(data, 1 << 16);
+        AlgoType algo = SortingEngine::predictBestAlgorithm(features);
+        double analysisMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        // The parser wrote the keys straight into `data`: sort them there
+        long long comparisons = 0;
+        long long allocationsBefore = heapAllocations();
+        start = chrono::steady_clock::now();
+        SortingEngine::sortWith(algo, data, comparisons);
+        double sortMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        long long sortAllocations = heapAllocations() - allocationsBefore;
+        double sortMBps = (double)load.elements * sizeof(int) / 1e6 / (sortMs / 1000.0);
+        
+        printSeparator('-', 70);
+        cout << "Algorithm:     " << SortingEngine::getAlgoName(algo) << endl;
+        cout << "Comparisons:   " << comparisons << endl;
+        cout << fixed << setprecision(1);
+        cout << "Read:          " << load.readMs << " ms" << endl;
+        cout << "Parse:         " << load.parseMs << " ms (" << load.parseMBps << " MB/s of text)" << endl;
+        cout << "Analysis:      " << analysisMs << " ms" << endl;
+        cout << "Sort:          " << sortMs << " ms (" << sortMBps << " MB/s of keys)" << endl;
+        cout << "Allocations:   " << sortAllocations << " heap allocations in the sort" << endl;
+        printSeparator();
+    } catch (const exception& e) {
+        cout << "\nError: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Analyze and sort a binary int32 file in place through a shared mapping
+int runMappedSort(const string& path, const MappedIntFile::Options& mapOptions) {
+    printSeparator();
+    cout << "    In-Place Sort of Mapped File" << endl;
+    printSeparator();
+    cout << "File:          " << path << endl;
+    try {
+        auto start = chrono::steady_clock::now();
+        MappedIntFile file(path, MappedIntFile::READ_WRITE, 0, mapOptions);
+        double mapMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Elements:      " << file.size() << endl;
+        if (file.size() < 2) throw runtime_error(path + " holds fewer than 2 elements");
+        
+        // The analysis is a linear scan over the pages; the uniqueness sample is capped
+        // the same way as for external sort runs so a huge file is not hashed in full
+        file.advise(MappedIntFile::ADVISE_SEQUENTIAL);
+        start = chrono::steady_clock::now();
+        DatasetFeatures features = SortingEngine::analyzeDataset(file.data(), file.size(), 1 << 16);
+        AlgoType algo = SortingEngine::predictBestAlgorithm(features);
+        double analysisMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        // Partitioning jumps around the array; the other algorithms sweep it
+        bool partitions = algo == QUICK_SORT || algo == BLOCK_QUICK_SORT || algo == VECTOR_QUICK_SORT;
+        file.advise(partitions ? MappedIntFile::ADVISE_RANDOM : MappedIntFile::ADVISE_SEQUENTIAL);
+        long long comparisons = 0;
+        start = chrono::steady_clock::now();
+        SortingEngine::sortWith(algo, file.data(), file.size(), comparisons);
+        double sortMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        start = chrono::steady_clock::now();
+        file.sync();
+        double syncMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        
+        printSeparator('-', 70);
+        cout << "Algorithm:     " << SortingEngine::getAlgoName(algo) << endl;
+        cout << "Comparisons:   " << comparisons << endl;
+        cout << fixed << setprecision(1);
+        cout << "Map:           " << mapMs << " ms" << endl;
+        cout << "Analysis:      " << analysisMs << " ms" << endl;
+        cout << "Sort:          " << sortMs << " ms" << endl;
+        cout << "Sync:          " << syncMs << " ms" << endl;
+        printSeparator();
+    } catch (const exception& e) {
+        cout << "\nError: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Sort a binary int32 file out of core and report the throughput
+int runExternalSort(const string& inputPath, const string& outputPath, size_t memoryMB, const string& tempDir) {
+    printSeparator();
+    cout << "    External Merge Sort" << endl;
+    printSeparator();
+    cout << "Input:         " << inputPath << endl;
+    cout << "Output:        " << outputPath << endl;
+    cout << "Memory budget: " << memoryMB << " MB" << endl;
+    
+    ExternalSortStats stats;
+    try {
+        stats = ExternalSorter::sortFile(inputPath, outputPath, memoryMB * 1024 * 1024, tempDir);
+    } catch (const exception& e) {
+        cout << "\nError: " << e.what() << endl;
+        return 1;
+    }
+    
+    int perAlgo[ALGO_TYPE_COUNT] = {};
+    for (AlgoType algo : stats.runAlgorithms) perAlgo[algo]++;
+    
+    printSeparator('-', 70);
+    cout << "Elements:      " << stats.elements << endl;
+    cout << "Sorted runs:   " << stats.runAlgorithms.size() << endl;
+    for (int a = 0; a < ALGO_TYPE_COUNT; a++) {
+        if (perAlgo[a] > 0) {
+            cout << "  " << left << setw(16) << SortingEngine::getAlgoName((AlgoType)a)
+                 << perAlgo[a] << " run(s)" << endl;
+        }
     }
+    cout << "Merge passes:  " << stats.mergePasses << endl;
+    cout << fixed << setprecision(1);
+    cout << "Run phase:     " << stats.runPhaseMs << " ms" << endl;
+    cout << "Merge phase:   " << stats.mergePhaseMs << " ms" << endl;
+    cout << "Total:         " << stats.totalMs << " ms" << endl;
+    cout << "Throughput:    " << stats.throughputMBps << " MB/s" << endl;
     printSeparator();
+    return 0;
 }
 
-int main() {
-    int choice, size, uniqueCount;
-    vector<int> dataset;
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--seed N] [--parallel | --race] [--mark-interference] [--top-k K]"
+         << " [--dataset NAME --size N [--param N]]" << endl;
+    cout << "  --parallel runs the algorithms concurrently, each pinned to its own core" << endl;
+    cout << "  --race runs them concurrently and stops the rest once one finishes" << endl;
+    cout << "  --mark-interference flags parallel runs that overlapped other runs" << endl;
+    cout << "  --online FILE predicts with an online selector that learns from every measured run;" << endl;
+    cout << "   its state is loaded from and saved to FILE" << endl;
+    cout << "  --rounds R (with --online) sorts R datasets with the selector's choices instead" << endl;
+    cout << "  --selector rules|knn|cost|probe|table picks the prediction strategy (default rules;" << endl;
+    cout << "   probe: the rules, but ambiguous inputs are decided by timing a sample;" << endl;
+    cout << "   table: the k-NN vote precompiled into a lookup table)" << endl;
+    cout << "   or: " << program << " --regret-grid [--sizes N,N,...] [--seeds S] [--csv FILE] [--selector NAME|all]" << endl;
+    cout << "  scores the predictor by regret (predicted time / best time) over every dataset" << endl;
+    cout << "  type and size, by type and by size, optionally writing one CSV row per dataset;" << endl;
+    cout << "  --selector all compares every strategy (and --online FILE) on the same runs" << endl;
+    cout << "  --top-k K only needs the K smallest elements (heap, intro and radix select)" << endl;
+    cout << "  --dataset runs one benchmark without the menu. NAME is one of:" << endl;
+    for (int t = 0; t < DATASET_TYPE_COUNT; t++) {
+        cout << "    " << left << setw(16) << SortingEngine::getDatasetFlag((DatasetType)t)
+             << SortingEngine::getDatasetName((DatasetType)t) << endl;
+    }
+    cout << "  --param sets the unique count (few-unique) or run count (sawtooth)" << endl;
+    cout << "  --append-batches B sorts the dataset, then appends 1% new values B times," << endl;
+    cout << "   re-sorting after each batch (tracked features, prefix merge)" << endl;
+    cout << "   or: " << program << " --tiny-batch COUNT" << endl;
+    cout << "  sorts COUNT arrays of 16-64 elements with the sorting-network batch engine" << endl;
+    cout << "  --branch-misses compares branchy and branchless kernels on --size random elements" << endl;
+    cout << "  --numa-sort sorts --dataset in parallel, NUMA-oblivious and with node-local memory;" << endl;
+    cout << "   --numa-nodes N splits the cores into N simulated nodes instead of detecting them" << endl;
+    cout << "  --payload W sorts records of the key plus a W-byte payload instead (0 = argsort only)" << endl;
+    cout << "  --save FILE writes the --dataset data to a binary int32 file instead" << endl;
+    cout << "  --load FILE benchmarks a file written with --save" << endl;
+    cout << "   or: " << program << " --sort-file FILE [--populate] [--hugepages]" << endl;
+    cout << "  sorts a binary int32 file in place through a memory mapping" << endl;
+    cout << "   or: " << program << " --load-text FILE" << endl;
+    cout << "  parses comma/whitespace-separated integers and sorts them" << endl;
+    cout << "   or: " << program << " --external-sort IN OUT [--memory MB] [--temp-dir DIR]" << endl;
+    cout << "  sorts a binary file of int32 keys that may be larger than RAM" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int choice, size, param;
+    
+    // Detect the caches and the vector kernels now, not inside the first timed sort
+    SortingEngine::cacheSizes();
+    SortingEngine::hasAvx2();
+    SortingEngine::hasAvx512();
+    
+    // Optional fixed seed: every dataset and pivot sequence becomes reproducible
+    bool fixedSeed = false;
+    uint64_t seedArg = 0;
+    
+    // Non-interactive mode: --dataset NAME --size N [--param N]
+    int batchType = -1, batchSize = 1000, batchParam = -1;
+    int appendBatches = 0;
+    int payloadWidth = -1;
+    bool branchMisses = false;
+    bool numaSort = false;
+    int numaNodes = 0;              // --numa-nodes N: simulated nodes (0: detect)
+    int tinyBatches = 0;
+    int onlineRounds = 0;
+    
+    // Regret grid: --regret-grid [--sizes N,N,...] [--seeds S] [--csv FILE]
+    bool regretGrid = false;
+    string selectorName = "rules";   // --selector rules|knn|cost|probe|table (all: A/B in the regret grid)
+    vector<int> gridSizes = {100, 1000, 10000, 100000};
+    int gridSeeds = 3;
+    string csvPath;
+    RunOptions options;
+    
+    // External sort mode: --external-sort IN OUT [--memory MB] [--temp-dir DIR]
+    string externalIn, externalOut, tempDir;
+    size_t memoryMB = 256;
+    
+    // Memory-mapped files: --save FILE, --load FILE, --sort-file FILE
+    string savePath, loadPath, sortPath;
+    
+    // Text input: --load-text FILE
+    string textPath;
+    MappedIntFile::Options mapOptions;
+    
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            char* end = nullptr;
+            seedArg = strtoull(argv[++i], &end, 10);
+            if (*end != '\0') {
+                cout << "Invalid seed: " << argv[i] << endl;
+                return 1;
+            }
+            fixedSeed = true;
+        } else if (arg == "--dataset" && i + 1 < argc) {
+            string name = argv[++i];
+            for (int t = 0; t < DATASET_TYPE_COUNT; t++) {
+                if (SortingEngine::getDatasetFlag((DatasetType)t) == name) batchType = t;
+            }
+            if (batchType < 0) {
+                cout << "Unknown dataset: " << name << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--parallel") {
+            options.parallel = true;
+        } else if (arg == "--external-sort" && i + 2 < argc) {
+            externalIn = argv[++i];
+            externalOut = argv[++i];
+        } else if (arg == "--memory" && i + 1 < argc) {
+            memoryMB = max(1, atoi(argv[++i]));
+        } else if (arg == "--temp-dir" && i + 1 < argc) {
+            tempDir = argv[++i];
+        } else if (arg == "--save" && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (arg == "--load" && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (arg == "--load-text" && i + 1 < argc) {
+            textPath = argv[++i];
+        } else if (arg == "--sort-file" && i + 1 < argc) {
+            sortPath = argv[++i];
+        } else if (arg == "--populate") {
+            mapOptions.populate = true;
+        } else if (arg == "--hugepages") {
+            mapOptions.hugePages = true;
+        } else if (arg == "--top-k" && i + 1 < argc) {
+            options.topK = max(1, atoi(argv[++i]));
+        } else if (arg == "--race") {
+            options.race = true;
+        } else if (arg == "--mark-interference") {
+            options.markInterference = true;
+        } else if (arg == "--size" && i + 1 < argc) {
+            batchSize = atoi(argv[++i]);
+        } else if (arg == "--param" && i + 1 < argc) {
+            batchParam = atoi(argv[++i]);
+        } else if (arg == "--append-batches" && i + 1 < argc) {
+            appendBatches = max(1, atoi(argv[++i]));
+        } else if (arg == "--regret-grid") {
+            regretGrid = true;
+        } else if (arg == "--sizes" && i + 1 < argc) {
+            gridSizes.clear();
+            stringstream list(argv[++i]);
+            string item;
+            while (getline(list, item, ',')) {
+                int n = atoi(item.c_str());
+                if (n < 10 || n > 10000000) {
+                    cout << "Invalid grid size: " << item << endl;
+                    return 1;
+                }
+                gridSizes.push_back(n);
+            }
+        } else if (arg == "--seeds" && i + 1 < argc) {
+            gridSeeds = max(1, atoi(argv[++i]));
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (arg == "--selector" && i + 1 < argc) {
+            selectorName = argv[++i];
+        } else if (arg == "--online" && i + 1 < argc) {
+            options.selectorPath = argv[++i];
+        } else if (arg == "--rounds" && i + 1 < argc) {
+            onlineRounds = max(1, atoi(argv[++i]));
+        } else if (arg == "--tiny-batch" && i + 1 < argc) {
+            tinyBatches = max(1, atoi(argv[++i]));
+        } else if (arg == "--branch-misses") {
+            branchMisses = true;
+        } else if (arg == "--numa-sort") {
+            numaSort = true;
+        } else if (arg == "--numa-nodes" && i + 1 < argc) {
+            numaNodes = max(1, atoi(argv[++i]));
+        } else if (arg == "--payload" && i + 1 < argc) {
+            payloadWidth = max(0, atoi(argv[++i]));
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    vector<unique_ptr<Selector> > strategies;
+    try {
+        if (selectorName == "all" && regretGrid) {
+            for (const string& name : selectorNames()) strategies.push_back(makeSelector(name));
+        } else {
+            strategies.push_back(makeSelector(selectorName));
+        }
+    } catch (const exception& e) {
+        cout << "Error: " << e.what() << endl;
+        return 1;
+    }
+    for (const auto& strategy : strategies) {
+        const TableSelector* table = dynamic_cast<const TableSelector*>(strategy.get());
+        if (table) {
+            cout << "Decision table " << table->name() << ": " << table->cells() << " cells, agrees with the source on "
+                 << fixed << setprecision(1) << table->agreement() * 100 << "% of " << table->testPoints()
+                 << " test points (" << table->repairedCells() << " cells rebuilt by majority vote)" << endl;
+        }
+    }
+    options.predictor = strategies[0].get();
+    
+    // The online selector starts from the chosen strategy's picks
+    unique_ptr<OnlineSelector> selector;
+    if (!options.selectorPath.empty()) {
+        const Selector* prior = strategies[0].get();
+        selector.reset(new OnlineSelector(0.05, [prior](const DatasetFeatures& f) { return prior->predict(f); }));
+        try {
+            if (selector->load(options.selectorPath)) {
+                cout << "Loaded online selector state from " << options.selectorPath << endl;
+            }
+        } catch (const exception& e) {
+            cout << "Error: " << e.what() << endl;
+            return 1;
+        }
+        options.selector = selector.get();
+        options.predictor = selector.get();
+    }
+    
+    if (regretGrid) {
+        vector<const Selector*> compared;
+        for (const auto& strategy : strategies) compared.push_back(strategy.get());
+        if (selector) compared.push_back(selector.get());
+        return runRegretGrid(gridSizes, gridSeeds, fixedSeed ? seedArg : SortingEngine::randomSeed(),
+                             csvPath, compared);
+    }
+    if (!externalIn.empty()) {
+        return runExternalSort(externalIn, externalOut, memoryMB, tempDir);
+    }
+    if (!textPath.empty()) {
+        return runTextSort(textPath);
+    }
+    if (!sortPath.empty()) {
+        return runMappedSort(sortPath, mapOptions);
+    }
+    if (tinyBatches > 0) {
+        try {
+            return runTinyBatch(tinyBatches, fixedSeed ? seedArg : SortingEngine::randomSeed());
+        } catch (const exception& e) {
+            cout << "\nError: " << e.what() << endl;
+            return 1;
+        }
+    }
+    if (branchMisses) {
+        if (batchSize < 10 || batchSize > 100000000) {
+            cout << "Invalid size! Please enter a value between 10 and 100000000." << endl;
+            return 1;
+        }
+        return runBranchBenchmark(batchSize, fixedSeed ? seedArg : SortingEngine::randomSeed());
+    }
+    if (!loadPath.empty()) {
+        return runLoadedBenchmark(loadPath, fixedSeed ? seedArg : SortingEngine::randomSeed(), options);
+    }
+    
+    if (batchType >= 0) {
+        if (batchSize < 10 || batchSize > 100000000) {
+            cout << "Invalid size! Please enter a value between 10 and 100000000." << endl;
+            return 1;
+        }
+        DatasetType type = (DatasetType)batchType;
+        if (batchParam < 0) batchParam = (type == SAWTOOTH_DATA) ? 8 : 5;
+        if (onlineRounds > 0 && selector) {
+            try {
+                return runOnlineTraffic(type, batchSize, clampDatasetParam(type, batchParam),
+                                        fixedSeed ? seedArg : SortingEngine::randomSeed(), onlineRounds,
+                                        *selector, options.selectorPath);
+            } catch (const exception& e) {
+                cout << "\nError: " << e.what() << endl;
+                return 1;
+            }
+        }
+        if (numaSort) {
+            try {
+                return runNumaSort(type, batchSize, clampDatasetParam(type, batchParam),
+                                   fixedSeed ? seedArg : SortingEngine::randomSeed(), numaNodes);
+            } catch (const exception& e) {
+                cout << "\nError: " << e.what() << endl;
+                return 1;
+            }
+        }
+        if (appendBatches > 0) {
+            return runAppendStream(type, batchSize, clampDatasetParam(type, batchParam),
+                                   fixedSeed ? seedArg : SortingEngine::randomSeed(), appendBatches);
+        }
+        if (payloadWidth >= 0) {
+            try {
+                return runRecordSort(type, batchSize, clampDatasetParam(type, batchParam),
+                                     fixedSeed ? seedArg : SortingEngine::randomSeed(), payloadWidth);
+            } catch (const exception& e) {
+                cout << "\nError: " << e.what() << endl;
+                return 1;
+            }
+        }
+        if (!savePath.empty()) {
+            return saveDataset(type, batchSize, clampDatasetParam(type, batchParam),
+                               fixedSeed ? seedArg : SortingEngine::randomSeed(), savePath);
+        }
+        try {
+            runSession(type, batchSize, clampDatasetParam(type, batchParam),
+                       fixedSeed ? seedArg : SortingEngine::randomSeed(), options);
+        } catch (const exception& e) {
+            cout << "\nError: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
     
     while (true) {
         displayMenu();
@@ -413,10 +5480,11 @@ int main() {
             break;
         }
         
-        if (choice < 1 || choice > 5) {
-            cout << "\nInvalid choice! Please select 1-5 or 0 to exit." << endl;
+        if (choice < 1 || choice > DATASET_TYPE_COUNT) {
+            cout << "\nInvalid choice! Please select 1-" << DATASET_TYPE_COUNT << " or 0 to exit." << endl;
             continue;
         }
+        DatasetType type = (DatasetType)(choice - 1);
         
         cout << "Enter dataset size (10-100000): ";
         cin >> size;
@@ -426,76 +5494,18 @@ int main() {
             continue;
         }
         
-        // Generate dataset based on user selection
-        cout << "\nGenerating dataset..." << endl;
+        param = 0;
+        if (type == FEW_UNIQUE_DATA) {
+            cout << "Enter number of unique values (2-50): ";
+            cin >> param;
+        } else if (type == SAWTOOTH_DATA) {
+            cout << "Enter number of sorted runs (2-1000): ";
+            cin >> param;
+        }
+        param = clampDatasetParam(type, param);
+        
         try {
-            switch(choice) {
-                case 1:
-                    dataset = SortingEngine::generateRandomDataset(size);
-                    break;
-                case 2:
-                    dataset = SortingEngine::generateNearlySorted(size);
-                    break;
-                case 3:
-                    dataset = SortingEngine::generateReversed(size);
-                    break;
-                case 4:
-                    cout << "Enter number of unique values (2-50): ";
-                    cin >> uniqueCount;
-                    if (uniqueCount < 2) uniqueCount = 2;
-                    if (uniqueCount > 50) uniqueCount = 50;
-                    dataset = SortingEngine::generateFewUnique(size, uniqueCount);
-                    break;
-                case 5:
-                    // Large Random Dataset (enforce minimum size)
-                    if (size < 10000) {
-                        cout << "Note: Large Random Dataset requires minimum size of 10000. Adjusting size to 10000." << endl;
-                        size = 10000;
-                    }
-                    dataset = SortingEngine::generateRandomDataset(size);
-                    break;
-            }
-            
-            // Display preview
-            displayDataPreview(dataset);
-            
-            // AI Analysis
-            cout << "\nPerforming AI analysis..." << endl;
-            DatasetFeatures features = SortingEngine::analyzeDataset(dataset);
-            AlgoType predicted = SortingEngine::predictBestAlgorithm(features);
-            displayAnalysis(features, predicted);
-            
-            // Run sorting algorithms
-            cout << "\nRunning sorting algorithms..." << endl;
-            vector<SortMetrics> results;
-            
-            // Skip O(n^2) algorithms for large datasets to save time
-            if (size <= 1000) {
-                cout << "  Running Bubble Sort..." << endl;
-                results.push_back(SortingEngine::runSort(BUBBLE_SORT, dataset));
-                cout << "  Running Insertion Sort..." << endl;
-                results.push_back(SortingEngine::runSort(INSERTION_SORT, dataset));
-            } else {
-                cout << "  (Skipping O(n²) algorithms for large dataset)" << endl;
-            }
-            
-            cout << "  Running Merge Sort..." << endl;
-            results.push_back(SortingEngine::runSort(MERGE_SORT, dataset));
-            cout << "  Running Quick Sort..." << endl;
-            results.push_back(SortingEngine::runSort(QUICK_SORT, dataset));
-            
-            // Find the fastest algorithm
-            string actualBest;
-            double minTime = 1e9;
-            for (const auto& r : results) {
-                if (r.executionTimeMs < minTime) {
-                    minTime = r.executionTimeMs;
-                    actualBest = r.algoName;
-                }
-            }
-            
-            // Display results
-            displayResults(results, actualBest, SortingEngine::getAlgoName(predicted));
+            runSession(type, size, param, fixedSeed ? seedArg : SortingEngine::randomSeed(), options);
             
             // Ask if user wants to continue
             cout << "\nPress Enter to continue...";
@@ -1,4 +1,5 @@
 #include <bits/stdc++.h>
+#include "AI_Module/HyperLogLog.h"
 using namespace std;
 
 enum AlgoType {
@@ -706,6 +707,7 @@ void quickSort(vector<int>& arr, int low, int high, long long& comparisons) {
 }
 
 // Task 4: AI Module
+
 DatasetFeatures analyzeDataset(const vector<int>& data) {
     DatasetFeatures features;
     features.size = data.size();
@@ -732,15 +734,13 @@ DatasetFeatures analyzeDataset(const vector<int>& data) {
     features.sortedness = (double)ascendingPairs / (features.size - 1);
     features.reversedness = (double)descendingPairs / (features.size - 1);
     
-    // Analyze uniqueness (sample first 1000 elements for performance)
-    int sampleSize = min(1000, features.size);
-    unordered_set<int> uniqueElements;
-    for (int i = 0; i < sampleSize; i++) {
-        uniqueElements.insert(data[i]);
-    }
+    // Analyze uniqueness over the whole array (a sorted head followed by a
+    // few-unique tail must not look unique): exact below 4096 elements, a
+    // HyperLogLog estimate above
+    double distinct = HyperLogLog::countDistinct(features.size, [&data](int i) { return data[i]; });
     
-    features.uniqueCount = uniqueElements.size();
-    features.uniqueRatio = (double)uniqueElements.size() / sampleSize;
+    features.uniqueRatio = min(1.0, distinct / features.size);
+    features.uniqueCount = (int)(features.uniqueRatio * features.size);
     
     if (features.sortedness >= 0.90) {
         features.type = "Nearly Sorted";
@@ -866,7 +866,8 @@ int main() {
     cout << "  > Type:        " << features.type << endl;
     cout << "  > Sortedness:  " << fixed << setprecision(1) << (features.sortedness * 100.0) << "%" << endl;
     cout << "  > Reversed:    " << (features.reversedness * 100.0) << "%" << endl;
-    cout << "  > Uniqueness:  " << (features.uniqueRatio * 100.0) << "% (Estimated from sample)" << endl;
+    cout << "  > Uniqueness:  " << (features.uniqueRatio * 100.0)
+         << (features.size < HyperLogLog::REGISTERS ? "% (exact)" : "% (HyperLogLog estimate)") << endl;
     cout << "  > Unique Count: " << features.uniqueCount << endl;
     cout << "------------------------------------------------" << endl;
     